@@ -0,0 +1,141 @@
+#include "branchless.h"
+#include "eytzinger.h"
+#include "linear-scan.h"
+#include "s-tree.h"
+#include "search-index.h"
+
+#include <stddef.h>
+#include <unistd.h>
+
+/** Search with whichever of the other searches is fastest for the size
+ *  of the array and the caches of the CPU, from the times of random
+ *  searches measured by the lab machine (1 CPU, AVX2, 48K L1d, 2M L2):
+ *
+ *    - A branchless count of the elements < element in a small array
+ *      (linear-scan.h) needs no index.  With AVX2 it is as fast as the
+ *      S-tree up to 64 elements, or 4 cache lines, and one element at
+ *      a time as fast as a binary search up to 16.
+ *
+ *    - With AVX2, the S-tree (s-tree.h) is 2-4x faster than the others
+ *      at every larger size, for single searches and batches alike.
+ *
+ *    - Without AVX2, the S-tree ranks its nodes one key at a time and
+ *      is slower than both binary searches.  The branchless binary
+ *      search of the array itself (branchless.h) is then the fastest
+ *      while the array fits in L2, and the Eytzinger layout
+ *      (eytzinger.h), which prefetches the cache misses of the levels
+ *      below, beyond it.
+ *
+ *  The index is kept for later calls with the same array (see
+ *  search-index.h).
+ */
+
+enum {
+  LINEAR_MAX = 64,          //max # of elements to count with AVX2
+  LINEAR_MAX_SSE = 16,      //without AVX2
+  DEFAULT_L2_SIZE = 256 * 1024,
+};
+
+typedef enum {
+  LINEAR,
+  BRANCHLESS,
+  EYTZINGER,
+  STREE,
+} Method;
+
+static struct {
+  IndexedArray indexed;
+  Method method;
+  Eytzinger *layout;  //only for EYTZINGER
+  STree *tree;        //only for STREE
+} INDEX;
+
+static int
+is_avx2(void)
+{
+#ifdef __x86_64__
+  return __builtin_cpu_supports("avx2");
+#else
+  return 0;
+#endif
+}
+
+/** Return the size of the L2 cache, or a typical size if unknown. */
+static long
+l2_size(void)
+{
+  long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  return (size > 0) ? size : DEFAULT_L2_SIZE;
+}
+
+static Method
+choose_method(int nElements)
+{
+  const int isAvx2 = is_avx2();
+  if (nElements <= (isAvx2 ? LINEAR_MAX : LINEAR_MAX_SSE)) return LINEAR;
+  if (isAvx2) return STREE;
+  if ((long)nElements * sizeof(int) <= l2_size()) return BRANCHLESS;
+  return EYTZINGER;
+}
+
+static void
+build_index(const int a[], int nElements)
+{
+  eytzinger_free(INDEX.layout);
+  stree_free(INDEX.tree);
+  INDEX.layout = NULL;
+  INDEX.tree = NULL;
+  INDEX.method = choose_method(nElements);
+  if (INDEX.method == EYTZINGER) {
+    INDEX.layout = eytzinger_build(a, nElements);
+  }
+  else if (INDEX.method == STREE) {
+    INDEX.tree = stree_build(a, nElements);
+  }
+}
+
+/** Return index of element in a[nElements]; < 0 if not found. */
+int
+search_for_element(int a[], int nElements, int element)
+{
+  if (index_is_stale(&INDEX.indexed, a, nElements)) {
+    build_index(a, nElements);
+  }
+  switch (INDEX.method) {
+  case LINEAR: {
+    int i = linear_rank(a, nElements, element);
+    return (i < nElements && a[i] == element) ? i : -1;
+  }
+  case BRANCHLESS:
+    return branchless_find(a, nElements, element);
+  case EYTZINGER:
+    return eytzinger_find(INDEX.layout, element);
+  case STREE:
+    return stree_find(INDEX.tree, element);
+  }
+  return -1;
+}
+
+/** Set outIdx[i] to the index of keys[i] in a[nElements], < 0 if not
+ *  found, for i < nKeys, in lockstep when the chosen search has a
+ *  batch version.
+ */
+void
+search_batch(int a[], int nElements, const int *keys, int *outIdx,
+             size_t nKeys)
+{
+  if (index_is_stale(&INDEX.indexed, a, nElements)) {
+    build_index(a, nElements);
+  }
+  if (INDEX.method == BRANCHLESS) {
+    branchless_find_batch(a, nElements, keys, outIdx, nKeys);
+  }
+  else if (INDEX.method == EYTZINGER) {
+    eytzinger_find_batch(INDEX.layout, keys, outIdx, nKeys);
+  }
+  else {
+    for (size_t i = 0; i < nKeys; i++) {
+      outIdx[i] = search_for_element(a, nElements, keys[i]);
+    }
+  }
+}
@@ -1,5 +1,7 @@
+#include "branchless.h"
 #include "int_compare.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 
 
@@ -10,3 +12,14 @@ search_for_element(int a[], int nElements, int element)
   int *p = bsearch(&element, a, nElements, sizeof(a[0]), int_compare);
   return (p) ? p - a : -1;		   
 }
+
+/** Set outIdx[i] to the index of keys[i] in a[nElements], < 0 if not
+ *  found, for i < nKeys, with branchless searches in lockstep
+ *  (branchless.h).
+ */
+void
+search_batch(int a[], int nElements, const int *keys, int *outIdx,
+             size_t nKeys)
+{
+  branchless_find_batch(a, nElements, keys, outIdx, nKeys);
+}
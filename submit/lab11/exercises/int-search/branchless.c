@@ -0,0 +1,68 @@
+#include "branchless.h"
+
+/** Each search looks for the lower bound of the key in the range
+ *  [base, base + len), which starts as the whole array.  A step
+ *  compares the key with the last element of the lower half, keeping
+ *  the upper half if it is smaller, and prefetches the two possible
+ *  probes of the next step, if there is one: on the last step len
+ *  drops to 1, and base[len/2 - 1] would be before the array.  When
+ *  len is 1, the lower bound is base or,
+ *  if *base is smaller than the key, the element after it.
+ */
+
+enum {
+  BATCH = 16,   //# of searches advanced in lockstep by the batch search
+};
+
+/** Return the index in a[nElements] of key, whose lower bound is base. */
+static inline int
+found_index(const int a[], int nElements, const int *base, int key)
+{
+  int i = base - a + (nElements > 0 && *base < key);
+  return (i < nElements && a[i] == key) ? i : -1;
+}
+
+int
+branchless_find(const int a[], int nElements, int key)
+{
+  const int *base = a;
+  for (int len = nElements; len > 1; ) {
+    const int half = len / 2;
+    len -= half;
+    if (len > 1) {
+      __builtin_prefetch(&base[len/2 - 1]);
+      __builtin_prefetch(&base[half + len/2 - 1]);
+    }
+    base += (base[half - 1] < key) * half;
+  }
+  return found_index(a, nElements, base, key);
+}
+
+/** Since len depends only on nElements, a group of BATCH searches takes
+ *  the same steps, so they are advanced together (see branchless.h).
+ */
+void
+branchless_find_batch(const int a[], int nElements, const int *keys,
+                      int *outIdx, size_t nKeys)
+{
+  for (size_t b = 0; b < nKeys; b += BATCH) {
+    const int n = (nKeys - b < BATCH) ? nKeys - b : BATCH;
+    const int *k = &keys[b];
+    const int *base[BATCH];
+    for (int q = 0; q < n; q++) base[q] = a;
+    for (int len = nElements; len > 1; ) {
+      const int half = len / 2;
+      len -= half;
+      for (int q = 0; q < n; q++) {
+        if (len > 1) {
+          __builtin_prefetch(&base[q][len/2 - 1]);
+          __builtin_prefetch(&base[q][half + len/2 - 1]);
+        }
+        base[q] += (base[q][half - 1] < k[q]) * half;
+      }
+    }
+    for (int q = 0; q < n; q++) {
+      outIdx[b + q] = found_index(a, nElements, base[q], k[q]);
+    }
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef _BRANCHLESS_H
+#define _BRANCHLESS_H
+
+#include <stddef.h>
+
+/** Binary search of a sorted a[nElements] without branches on the
+ *  data, which halves the range with a conditional move instead of a
+ *  mispredicted branch.
+ */
+
+/** Return the index of key in a[nElements], or -1 if none. */
+int branchless_find(const int a[], int nElements, int key);
+
+/** Set outIdx[i] to branchless_find(a, nElements, keys[i]) for
+ *  i < nKeys, advancing groups of searches in lockstep: one step of
+ *  every search of the group, each prefetching its next probe, before
+ *  the next step of any, so that the cache misses of the group overlap
+ *  instead of stalling one search at a time.  eytzinger_find_batch()
+ *  of eytzinger.h does the same.
+ */
+void branchless_find_batch(const int a[], int nElements, const int *keys,
+                           int *outIdx, size_t nKeys);
+
+#endif // ifndef _BRANCHLESS_H
@@ -0,0 +1,43 @@
+#include "eytzinger.h"
+#include "search-index.h"
+
+#include <stddef.h>
+
+/** Binary search over the sorted array rearranged into Eytzinger
+ *  (breadth-first) order (eytzinger.h), so that the first levels of
+ *  every search share the same few cache lines and the next cache line
+ *  of a search is prefetched 4 levels ahead.  The layout is kept for
+ *  later calls with the same array (see search-index.h).
+ */
+
+static struct {
+  IndexedArray indexed;
+  Eytzinger *layout;
+} INDEX;
+
+static const Eytzinger *
+layout_of(const int a[], int nElements)
+{
+  if (index_is_stale(&INDEX.indexed, a, nElements)) {
+    eytzinger_free(INDEX.layout);
+    INDEX.layout = eytzinger_build(a, nElements);
+  }
+  return INDEX.layout;
+}
+
+/** Return index of element in a[nElements]; < 0 if not found. */
+int
+search_for_element(int a[], int nElements, int element)
+{
+  return eytzinger_find(layout_of(a, nElements), element);
+}
+
+/** Set outIdx[i] to the index of keys[i] in a[nElements], < 0 if not
+ *  found, for i < nKeys, advancing groups of searches in lockstep.
+ */
+void
+search_batch(int a[], int nElements, const int *keys, int *outIdx,
+             size_t nKeys)
+{
+  eytzinger_find_batch(layout_of(a, nElements), keys, outIdx, nKeys);
+}
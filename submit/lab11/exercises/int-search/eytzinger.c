@@ -0,0 +1,120 @@
+#include "eytzinger.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  CACHE_LINE = 64,
+  KEYS_PER_LINE = CACHE_LINE / sizeof(int),
+  BATCH = 16,   //# of searches advanced in lockstep by the batch search
+};
+
+static void *
+must_aligned_alloc(size_t size)
+{
+  //aligned_alloc() needs a multiple of the alignment
+  size = (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+  void *p = aligned_alloc(CACHE_LINE, size);
+  if (!p) {
+    fprintf(stderr, "could not malloc search index: %s\n", strerror(errno));
+    exit(1);
+  }
+  return p;
+}
+
+/** Fill the subtree of node k with the elements of a[] from *i on, in
+ *  order, returning the next unused element in *i.
+ */
+static void
+fill(Eytzinger *layout, const int a[], int k, int *i)
+{
+  if (k <= layout->nElements) {
+    fill(layout, a, 2*k, i);
+    layout->keys[k] = a[*i];
+    layout->index[k] = (*i)++;
+    fill(layout, a, 2*k + 1, i);
+  }
+}
+
+Eytzinger *
+eytzinger_build(const int a[], int nElements)
+{
+  Eytzinger *layout = malloc(sizeof(Eytzinger));
+  if (!layout) {
+    fprintf(stderr, "could not malloc search index: %s\n", strerror(errno));
+    exit(1);
+  }
+  layout->nElements = nElements;
+  layout->keys = must_aligned_alloc((nElements + 1) * sizeof(int));
+  layout->index = must_aligned_alloc((nElements + 1) * sizeof(int));
+  int i = 0;
+  fill(layout, a, 1, &i);
+  return layout;
+}
+
+void
+eytzinger_free(Eytzinger *layout)
+{
+  if (layout) {
+    free(layout->keys);
+    free(layout->index);
+  }
+  free(layout);
+}
+
+/** Return the index in the array of the key at node k, where the
+ *  search for key left the tree, or -1 if it is not key.
+ */
+static inline int
+found_index(const Eytzinger *layout, unsigned k, int key)
+{
+  //k went right after its last left turn at the lower bound: undo
+  //those right turns and the left turn
+  k >>= __builtin_ffs(~k);
+  return (k != 0 && layout->keys[k] == key) ? layout->index[k] : -1;
+}
+
+int
+eytzinger_find(const Eytzinger *layout, int key)
+{
+  const int *keys = layout->keys;
+  unsigned k = 1;
+  while (k <= (unsigned)layout->nElements) {
+    //a hint only, so a line past the end does no harm
+    __builtin_prefetch(keys + (size_t)k * KEYS_PER_LINE);
+    k = 2*k + (keys[k] < key);
+  }
+  return found_index(layout, k, key);
+}
+
+/** Every search goes down the same # of levels but the last, so a
+ *  group of BATCH searches is advanced a level at a time, each
+ *  prefetching its node 4 levels below (see branchless_find_batch() in
+ *  branchless.h).
+ */
+void
+eytzinger_find_batch(const Eytzinger *layout, const int *keys, int *outIdx,
+                     size_t nKeys)
+{
+  const int *tree = layout->keys;
+  const unsigned n = layout->nElements;
+  for (size_t b = 0; b < nKeys; b += BATCH) {
+    const int nb = (nKeys - b < BATCH) ? nKeys - b : BATCH;
+    const int *x = &keys[b];
+    unsigned k[BATCH];
+    for (int q = 0; q < nb; q++) k[q] = 1;
+    //all searches are still in the tree until the last level
+    for (unsigned level = 2; level <= n; level *= 2) {
+      for (int q = 0; q < nb; q++) {
+        __builtin_prefetch(tree + (size_t)k[q] * KEYS_PER_LINE);
+        k[q] = 2*k[q] + (tree[k[q]] < x[q]);
+      }
+    }
+    for (int q = 0; q < nb; q++) {
+      if (k[q] <= n) k[q] = 2*k[q] + (tree[k[q]] < x[q]);
+      outIdx[b + q] = found_index(layout, k[q], x[q]);
+    }
+  }
+}
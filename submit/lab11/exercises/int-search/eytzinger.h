@@ -0,0 +1,35 @@
+#ifndef _EYTZINGER_H
+#define _EYTZINGER_H
+
+#include <stddef.h>
+
+/** Copy of a sorted int array in Eytzinger (breadth-first) order: the
+ *  root is at index 1 and the children of node k are at 2k and 2k + 1,
+ *  so that the first levels of every search share the same few cache
+ *  lines and the nodes 4 levels below node k, at 16k ... 16k + 15, fill
+ *  exactly one 64-byte cache line, which is prefetched while the 4
+ *  levels above it are searched.  Each step of a search is
+ *  k = 2k + (key[k] < element), without a branch.
+ */
+
+typedef struct {
+  int nElements;
+  int *keys;          //keys[1 .. nElements] in Eytzinger order
+  int *index;         //index[k]: index in the array of keys[k]
+} Eytzinger;
+
+/** Return the Eytzinger layout of the sorted a[nElements]. */
+Eytzinger *eytzinger_build(const int a[], int nElements);
+
+void eytzinger_free(Eytzinger *layout);
+
+/** Return the index in the array of key, or -1 if none. */
+int eytzinger_find(const Eytzinger *layout, int key);
+
+/** Set outIdx[i] to eytzinger_find(layout, keys[i]) for i < nKeys,
+ *  advancing groups of searches in lockstep.
+ */
+void eytzinger_find_batch(const Eytzinger *layout, const int *keys,
+                          int *outIdx, size_t nKeys);
+
+#endif // ifndef _EYTZINGER_H
@@ -3,6 +3,7 @@
  */
 int 
 int_compare(const void *p1, const void *p2) {
-  return *(int*)p1 - *(int*)p2;
+  int i1 = *(const int*)p1, i2 = *(const int*)p2;
+  return (i1 > i2) - (i1 < i2);  //the difference could overflow
 }
 
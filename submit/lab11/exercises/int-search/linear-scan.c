@@ -0,0 +1,143 @@
+#include "linear-scan.h"
+
+#ifdef __x86_64__
+  #include <immintrin.h>
+#endif
+
+/** Each SIMD scan compares one vector of elements per step, with one
+ *  branch per vector.  Rather than finishing a partial last vector one
+ *  element at a time, it compares the last vector's worth of elements
+ *  of the array, which overlaps the elements already compared but
+ *  finds the same first match since none of those matched.  Only
+ *  arrays smaller than one vector are scanned one element at a time.
+ */
+
+static int
+scan_c(const int a[], int nElements, int key)
+{
+  for (int i = 0; i < nElements; i++) {
+    if (a[i] == key) return i;
+  }
+  return -1;
+}
+
+#ifdef __x86_64__
+
+/** Return the index of the first element equal to keys in the 4 ints
+ *  at p, or -1 if none.
+ */
+static inline int
+match_sse2(const int *p, __m128i keys)
+{
+  __m128i eq = _mm_cmpeq_epi32(keys, _mm_loadu_si128((const __m128i *)p));
+  unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+  return mask ? __builtin_ctz(mask) : -1;
+}
+
+//SSE2 is part of x86-64, so needs no check
+static int
+scan_sse2(const int a[], int nElements, int key)
+{
+  enum { N = 4 };
+  if (nElements < N) return scan_c(a, nElements, key);
+  const __m128i keys = _mm_set1_epi32(key);
+  for (int i = 0; i < nElements - N; i += N) {
+    int j = match_sse2(&a[i], keys);
+    if (j >= 0) return i + j;
+  }
+  int j = match_sse2(&a[nElements - N], keys);
+  return (j < 0) ? -1 : nElements - N + j;
+}
+
+/** Return the index of the first element equal to keys in the 8 ints
+ *  at p, or -1 if none.
+ */
+__attribute__((target("avx2")))
+static inline int
+match_avx2(const int *p, __m256i keys)
+{
+  __m256i eq =
+    _mm256_cmpeq_epi32(keys, _mm256_loadu_si256((const __m256i *)p));
+  unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+  return mask ? __builtin_ctz(mask) : -1;
+}
+
+__attribute__((target("avx2")))
+static int
+scan_avx2(const int a[], int nElements, int key)
+{
+  enum { N = 8 };
+  if (nElements < N) return scan_sse2(a, nElements, key);
+  const __m256i keys = _mm256_set1_epi32(key);
+  for (int i = 0; i < nElements - N; i += N) {
+    int j = match_avx2(&a[i], keys);
+    if (j >= 0) return i + j;
+  }
+  int j = match_avx2(&a[nElements - N], keys);
+  return (j < 0) ? -1 : nElements - N + j;
+}
+
+__attribute__((target("avx2")))
+static int
+rank_avx2(const int a[], int nElements, int key)
+{
+  enum { N = 8 };
+  const __m256i keys = _mm256_set1_epi32(key);
+  __m256i counts = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + N <= nElements; i += N) {
+    //each lane of a comparison is -1 where the element is < key
+    __m256i elements = _mm256_loadu_si256((const __m256i *)&a[i]);
+    counts = _mm256_sub_epi32(counts, _mm256_cmpgt_epi32(keys, elements));
+  }
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(counts),
+                              _mm256_extracti128_si256(counts, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  int rank = _mm_cvtsi128_si32(sum);
+  for (; i < nElements; i++) rank += (a[i] < key);
+  return rank;
+}
+
+#endif //ifdef __x86_64__
+
+static int
+rank_c(const int a[], int nElements, int key)
+{
+  int rank = 0;
+  for (int i = 0; i < nElements; i++) rank += (a[i] < key);
+  return rank;
+}
+
+static int IS_AVX2 = -1;
+
+static int
+is_avx2(void)
+{
+#ifdef __x86_64__
+  if (IS_AVX2 < 0) IS_AVX2 = __builtin_cpu_supports("avx2");
+#else
+  IS_AVX2 = 0;
+#endif
+  return IS_AVX2;
+}
+
+int
+linear_scan(const int a[], int nElements, int key)
+{
+#ifdef __x86_64__
+  return is_avx2() ? scan_avx2(a, nElements, key)
+                   : scan_sse2(a, nElements, key);
+#else
+  return scan_c(a, nElements, key);
+#endif
+}
+
+int
+linear_rank(const int a[], int nElements, int key)
+{
+#ifdef __x86_64__
+  if (is_avx2()) return rank_avx2(a, nElements, key);
+#endif
+  return rank_c(a, nElements, key);
+}
@@ -0,0 +1,19 @@
+#ifndef _LINEAR_SCAN_H
+#define _LINEAR_SCAN_H
+
+/** Return the index of the first element equal to key in a[nElements],
+ *  or -1 if none, comparing 8 elements at a time with AVX2, or 4 with SSE2,
+ *  when the CPU has them.  Unlike a tree, it needs no index and reads
+ *  the array sequentially, so it is the fastest search of small arrays.
+ */
+int linear_scan(const int a[], int nElements, int key);
+
+/** Return the # of elements < key in a[nElements], which for a sorted
+ *  array is the index of the lower bound of key.  It compares all the
+ *  elements, 8 at a time with AVX2, without a branch on the data, so
+ *  its time does not depend on where key is and it beats a binary
+ *  search of a small sorted array.
+ */
+int linear_rank(const int a[], int nElements, int key);
+
+#endif // ifndef _LINEAR_SCAN_H
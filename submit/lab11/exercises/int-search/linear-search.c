@@ -1,12 +1,22 @@
+#include "linear-scan.h"
+
+#include <stddef.h>
+
 /** Return index of element in a[nElements]; < 0 if not found. */
 int
 search_for_element(int a[], int nElements, int element)
 {
-  //@TODO add your code here to meet above spec.
-  for(int i = 0; i < nElements; i++){
-    if(a[i] == element){
-      return i;
-    }
+  return linear_scan(a, nElements, element);
+}
+
+/** Set outIdx[i] to the index of keys[i] in a[nElements], < 0 if not
+ *  found, for i < nKeys.
+ */
+void
+search_batch(int a[], int nElements, const int *keys, int *outIdx,
+             size_t nKeys)
+{
+  for (size_t i = 0; i < nKeys; i++) {
+    outIdx[i] = search_for_element(a, nElements, keys[i]);
   }
-  return -1;
 }
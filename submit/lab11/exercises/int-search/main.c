@@ -1,18 +1,42 @@
 #include "int_compare.h"
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 /** Return index of element in a[nElements]; < 0 if not found. */
 int search_for_element(int a[], int nElements, int element);
 
+/** Set outIdx[i] to search_for_element(a, nElements, keys[i]) for
+ *  i < nKeys, possibly overlapping the searches.
+ */
+void search_batch(int a[], int nElements, const int *keys, int *outIdx,
+                  size_t nKeys);
+
+static void *
+must_malloc(size_t size)
+{
+  void *p = malloc(size);
+  if (!p) {
+    fprintf(stderr, "could not malloc %zu bytes\n", size);
+    exit(1);
+  }
+  return p;
+}
+
 
-/** Perform nTests searches for all elements in a[].  
+/** Perform nTests searches for all elements in a[], one at a time
+ *  and in batches.
  */
 static void
 do_search(int a[], int nElements, int nTests)
 {
+  //a batch of all elements and one of all elements + 1
+  int *keys1 = must_malloc(nElements * sizeof(int));
+  int *batchIndex = must_malloc(nElements * sizeof(int));
+  int *batchIndex1 = must_malloc(nElements * sizeof(int));
+  for (int i = 0; i < nElements; i++) keys1[i] = a[i] + 1;
   for (int t = 0; t < nTests; t++) {
     for (int i = 0; i < nElements; i++) {
       int foundIndex = search_for_element(a, nElements, a[i]);
@@ -20,7 +44,16 @@ do_search(int a[], int nElements, int nTests)
       int foundIndex1 = search_for_element(a, nElements, a[i] + 1);
       assert(foundIndex1 < 0 || foundIndex1 == i + 1);
     }
+    search_batch(a, nElements, a, batchIndex, nElements);
+    search_batch(a, nElements, keys1, batchIndex1, nElements);
+    for (int i = 0; i < nElements; i++) {
+      assert(batchIndex[i] == i);
+      assert(batchIndex1[i] < 0 || batchIndex1[i] == i + 1);
+    }
   }
+  free(keys1);
+  free(batchIndex);
+  free(batchIndex1);
 }
 
 int 
@@ -33,11 +66,18 @@ main(int argc, const char *argv[])
     fprintf(stderr, "usage: %s NUM_ELEMENTS NUM_TESTS\n", argv[0]);
     exit(1);
   }
-  int a[nElements];
+  //on the heap: arrays larger than the last-level cache overflow the stack
+  int *a = must_malloc(nElements * sizeof(int));
   for (int i = 0; i < nElements; i++) {
     a[i] = rand();
   }
   qsort(a, nElements, sizeof(int), int_compare);
-  do_search(a, nElements, nTests);
+  //the checks in do_search() need distinct elements
+  int nDistinct = 1;
+  for (int i = 1; i < nElements; i++) {
+    if (a[i] != a[nDistinct - 1]) a[nDistinct++] = a[i];
+  }
+  do_search(a, nDistinct, nTests);
+  free(a);
   return 0;
 }
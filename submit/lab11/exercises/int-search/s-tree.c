@@ -0,0 +1,168 @@
+#include "s-tree.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __x86_64__
+  #include <immintrin.h>
+#endif
+
+/** Layer 0 holds the sorted elements themselves in blocks of B, padded
+ *  with INT_MAX, so that a leaf position is an index into the array.
+ *  Each layer above has a node per B + 1 nodes of the layer below, up
+ *  to a single root.  Key j of a node is the smallest element under
+ *  its child j + 1, or INT_MAX if there is no such child.
+ *
+ *  Searching for x, the # i of keys < x in a node is the child to
+ *  descend into: the elements under children < i are all smaller than
+ *  key i - 1, which is < x, and key i, the first element after child
+ *  i, is >= x.  In the leaf, the # of elements < x is then the offset
+ *  of the lower bound from the start of the leaf; if all of them are,
+ *  the lower bound is the first element of the next leaf, which
+ *  follows it in layer 0.
+ */
+
+enum {
+  B = STREE_B,
+  CACHE_LINE = B * sizeof(int),
+};
+
+static void *
+must_aligned_alloc(size_t size)
+{
+  void *p = aligned_alloc(CACHE_LINE, size);
+  if (!p) {
+    fprintf(stderr, "could not malloc S-tree: %s\n", strerror(errno));
+    exit(1);
+  }
+  return p;
+}
+
+/** Return the smallest element under node k of layer h, or INT_MAX if
+ *  there is no such node.
+ */
+static int
+subtree_min(const STree *tree, long k, int h)
+{
+  const long nLeaves = tree->offsets[1] / B;
+  for (; h > 0 && k < nLeaves; h--) k *= B + 1;
+  return (k < nLeaves) ? tree->keys[k * B] : INT_MAX;
+}
+
+STree *
+stree_build(const int a[], int nElements)
+{
+  STree *tree = malloc(sizeof(STree));
+  if (!tree) {
+    fprintf(stderr, "could not malloc S-tree: %s\n", strerror(errno));
+    exit(1);
+  }
+  tree->nElements = nElements;
+  //# of nodes in each layer, and the offset of each layer in keys
+  int nNodes = (nElements + B - 1) / B;
+  if (nNodes == 0) nNodes = 1;
+  long size = 0;
+  int h = 0;
+  for (;;) {
+    tree->offsets[h] = size;
+    size += (long)nNodes * B;
+    h++;
+    if (nNodes == 1) break;
+    nNodes = (nNodes + B) / (B + 1);
+  }
+  tree->height = h;
+  tree->offsets[h] = size;
+  tree->keys = must_aligned_alloc(size * sizeof(int));
+  tree->isAvx2 = 0;
+#ifdef __x86_64__
+  tree->isAvx2 = __builtin_cpu_supports("avx2");
+#endif
+
+  memcpy(tree->keys, a, nElements * sizeof(int));
+  for (long i = nElements; i < tree->offsets[1]; i++) tree->keys[i] = INT_MAX;
+  for (h = 1; h < tree->height; h++) {
+    int *layer = &tree->keys[tree->offsets[h]];
+    long layerNodes = (tree->offsets[h + 1] - tree->offsets[h]) / B;
+    for (long k = 0; k < layerNodes; k++) {
+      for (int j = 0; j < B; j++) {
+        layer[k*B + j] = subtree_min(tree, k*(B + 1) + j + 1, h - 1);
+      }
+    }
+  }
+  return tree;
+}
+
+void
+stree_free(STree *tree)
+{
+  if (tree) free(tree->keys);
+  free(tree);
+}
+
+/** Return the # of keys < x in node. */
+static inline int
+rank_c(const int *node, int x)
+{
+  int rank = 0;
+  for (int j = 0; j < B; j++) rank += (node[j] < x);
+  return rank;
+}
+
+static int
+lower_bound_c(const STree *tree, int x)
+{
+  long k = 0;
+  for (int h = tree->height - 1; h > 0; h--) {
+    k = k*(B + 1) + rank_c(&tree->keys[tree->offsets[h] + k*B], x);
+  }
+  return k*B + rank_c(&tree->keys[k*B], x);
+}
+
+#ifdef __x86_64__
+
+/** Return the # of keys < x in node, for x broadcast into xs. */
+__attribute__((target("avx2")))
+static inline int
+rank_avx2(const int *node, const __m256i *xs)
+{
+  __m256i lo = _mm256_load_si256((const __m256i *)node);
+  __m256i hi = _mm256_load_si256((const __m256i *)node + 1);
+  unsigned less =
+    _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(*xs, lo))) |
+    _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(*xs, hi)))
+      << 8;
+  return __builtin_popcount(less);
+}
+
+__attribute__((target("avx2")))
+static int
+lower_bound_avx2(const STree *tree, int x)
+{
+  const __m256i xs = _mm256_set1_epi32(x);
+  long k = 0;
+  for (int h = tree->height - 1; h > 0; h--) {
+    k = k*(B + 1) + rank_avx2(&tree->keys[tree->offsets[h] + k*B], &xs);
+  }
+  return k*B + rank_avx2(&tree->keys[k*B], &xs);
+}
+
+#endif //ifdef __x86_64__
+
+int
+stree_lower_bound(const STree *tree, int key)
+{
+#ifdef __x86_64__
+  if (tree->isAvx2) return lower_bound_avx2(tree, key);
+#endif
+  return lower_bound_c(tree, key);
+}
+
+int
+stree_find(const STree *tree, int key)
+{
+  int i = stree_lower_bound(tree, key);
+  return (i < tree->nElements && tree->keys[i] == key) ? i : -1;
+}
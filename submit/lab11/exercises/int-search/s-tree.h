@@ -0,0 +1,38 @@
+#ifndef _S_TREE_H
+#define _S_TREE_H
+
+/** Static B+tree (S-tree) index of a sorted int array: an implicit tree
+ *  of nodes of 16 keys, each filling one 64-byte cache line, with no
+ *  pointers: the children of node k are nodes 17k ... 17k + 16 of the
+ *  layer below.  A search reads one cache line per layer and compares
+ *  the key with all 16 keys of a node at once.
+ */
+
+enum {
+  STREE_B = 16,           //keys per node
+  STREE_MAX_HEIGHT = 10,  //enough for any int # of elements
+};
+
+typedef struct {
+  int nElements;
+  int height;           //# of layers, the leaves being layer 0
+  int *keys;            //all layers, aligned to cache lines
+  //layer h is keys[offsets[h] .. offsets[h + 1] - 1]
+  long offsets[STREE_MAX_HEIGHT + 1];
+  int isAvx2;           //search with AVX2
+} STree;
+
+/** Return an S-tree for the sorted a[nElements], which it copies. */
+STree *stree_build(const int a[], int nElements);
+
+void stree_free(STree *tree);
+
+/** Return the index in the array of the first element >= key, or
+ *  tree->nElements if there is none.
+ */
+int stree_lower_bound(const STree *tree, int key);
+
+/** Return the index of an element equal to key, or -1 if none. */
+int stree_find(const STree *tree, int key);
+
+#endif // ifndef _S_TREE_H
@@ -0,0 +1,17 @@
+#include "search-index.h"
+
+int
+index_is_stale(IndexedArray *indexed, const int a[], int nElements)
+{
+  int first = (nElements > 0) ? a[0] : 0;
+  int last = (nElements > 0) ? a[nElements - 1] : 0;
+  if (indexed->a == a && indexed->nElements == nElements &&
+      indexed->first == first && indexed->last == last) {
+    return 0;
+  }
+  indexed->a = a;
+  indexed->nElements = nElements;
+  indexed->first = first;
+  indexed->last = last;
+  return 1;
+}
@@ -0,0 +1,30 @@
+#ifndef _SEARCH_INDEX_H
+#define _SEARCH_INDEX_H
+
+/** The searches which need an index of the array (a copy of it in
+ *  another layout) build it on the first call for an array and keep it
+ *  for later calls with the same array, so the array must not change
+ *  between calls.
+ *
+ *  An array is recognized by its address and size, and by its first
+ *  and last elements, so that a new array allocated where a freed one
+ *  was usually gets an index of its own.  A new array of the same size
+ *  and the same first and last elements at the address of a freed one
+ *  is still taken for the old one and searched with its stale index:
+ *  since search_for_element() cannot be told that an array has gone,
+ *  a program must not free a searched array and search another in its
+ *  place.
+ */
+
+typedef struct {
+  const int *a;       //sorted array of the index, NULL if none
+  int nElements;
+  int first, last;    //a[0] and a[nElements - 1] when indexed
+} IndexedArray;
+
+/** Return non-zero if the index of indexed is not that of a[nElements],
+ *  which must then be (re)built, and make indexed that of a[nElements].
+ */
+int index_is_stale(IndexedArray *indexed, const int a[], int nElements);
+
+#endif // ifndef _SEARCH_INDEX_H
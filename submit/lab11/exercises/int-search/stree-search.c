@@ -0,0 +1,39 @@
+#include "s-tree.h"
+#include "search-index.h"
+
+#include <stddef.h>
+
+/** Search using an S-tree (s-tree.h) over a copy of the sorted array:
+ *  one cache line and one 16-way comparison per level, with a tree of
+ *  only 5 levels for a million elements, against 20 for a binary search.
+ *  The tree is kept for later calls with the same array (see
+ *  search-index.h).
+ */
+
+static struct {
+  IndexedArray indexed;
+  STree *tree;
+} INDEX;
+
+/** Return index of element in a[nElements]; < 0 if not found. */
+int
+search_for_element(int a[], int nElements, int element)
+{
+  if (index_is_stale(&INDEX.indexed, a, nElements)) {
+    stree_free(INDEX.tree);
+    INDEX.tree = stree_build(a, nElements);
+  }
+  return stree_find(INDEX.tree, element);
+}
+
+/** Set outIdx[i] to the index of keys[i] in a[nElements], < 0 if not
+ *  found, for i < nKeys.
+ */
+void
+search_batch(int a[], int nElements, const int *keys, int *outIdx,
+             size_t nKeys)
+{
+  for (size_t i = 0; i < nKeys; i++) {
+    outIdx[i] = search_for_element(a, nElements, keys[i]);
+  }
+}
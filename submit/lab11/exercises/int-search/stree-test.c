@@ -0,0 +1,98 @@
+#include "int_compare.h"
+#include "s-tree.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Check stree_lower_bound() against the sorted array for the elements,
+ *  the keys next to them and keys outside their range, which the
+ *  stree_find() of stree-search alone does not tell apart from a miss.
+ *  The arrays are random, for sizes around the node size and spanning
+ *  several layers, and are also run with INT_MIN and INT_MAX as their
+ *  ends and with duplicates.
+ */
+
+static const int SIZES[] = { 1, 2, 15, 16, 17, 33, 272, 289, 300, 5000,
+                             100000 };
+
+typedef enum {
+  RANDOM,           //distinct random elements
+  EXTREMES,         //also INT_MIN and INT_MAX, equal to the padding
+  DUPLICATES,       //a few distinct values repeated
+} Kind;
+
+static const char *const KIND_NAMES[] = {
+  "random", "extremes", "duplicates"
+};
+
+static int *
+sorted_array(Kind kind, int nElements)
+{
+  int *a = malloc(nElements * sizeof(int));
+  if (!a) {
+    fprintf(stderr, "could not malloc %d ints\n", nElements);
+    exit(1);
+  }
+  for (int i = 0; i < nElements; i++) {
+    a[i] = (kind == DUPLICATES) ? rand() % 7 : rand() - RAND_MAX/2;
+  }
+  if (kind == EXTREMES) {
+    a[0] = INT_MIN;
+    a[nElements - 1] = INT_MAX;
+  }
+  qsort(a, nElements, sizeof(int), int_compare);
+  return a;
+}
+
+/** Return 1 if stree_lower_bound(tree, key) is the lower bound of key in
+ *  the sorted a[nElements], printing the error if not.
+ */
+static int
+check_lower_bound(const STree *tree, const int a[], int nElements, int key)
+{
+  int i = stree_lower_bound(tree, key);
+  if (0 <= i && i <= nElements && (i == nElements || a[i] >= key) &&
+      (i == 0 || a[i - 1] < key)) {
+    return 1;
+  }
+  printf("FAIL: n=%d: lower bound of %d is %d\n", nElements, key, i);
+  return 0;
+}
+
+/** Return 1 if the S-tree of a[nElements] passes. */
+static int
+test_tree(const int a[], int nElements)
+{
+  STree *tree = stree_build(a, nElements);
+  int isOk = check_lower_bound(tree, a, nElements, INT_MIN) &&
+    check_lower_bound(tree, a, nElements, INT_MAX);
+  for (int i = 0; i < nElements && isOk; i++) {
+    isOk = check_lower_bound(tree, a, nElements, a[i]) &&
+      (a[i] == INT_MIN || check_lower_bound(tree, a, nElements, a[i] - 1)) &&
+      (a[i] == INT_MAX || check_lower_bound(tree, a, nElements, a[i] + 1));
+  }
+  stree_free(tree);
+  return isOk;
+}
+
+int
+main(void)
+{
+  int nTests = 0, nFail = 0;
+  srand(1);
+  for (Kind kind = RANDOM; kind <= DUPLICATES; kind++) {
+    for (int s = 0; s < sizeof(SIZES)/sizeof(SIZES[0]); s++) {
+      int nElements = SIZES[s];
+      if (kind == EXTREMES && nElements < 2) continue;
+      int *a = sorted_array(kind, nElements);
+      int isOk = test_tree(a, nElements);
+      if (!isOk) printf("  in %s array\n", KIND_NAMES[kind]);
+      nFail += !isOk;
+      nTests++;
+      free(a);
+    }
+  }
+  printf("stree: %d of %d tests passed\n", nTests - nFail, nTests);
+  return nFail > 0;
+}
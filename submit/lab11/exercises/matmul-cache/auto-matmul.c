@@ -0,0 +1,32 @@
+#include "matmul.h"
+#include "gemm.h"
+#include "sparse.h"
+
+/** Matrix multiply which picks the sparse or dense algorithm from the
+ *  density of A.  Converting A to CSR costs one pass over A, after
+ *  which SpMM does 2 n nnz(A) flops at a small fraction of the rate of
+ *  the packed dense kernel.  With matmul-bench -d at n = 512..2048 the
+ *  two break even at about 8% nonzeros; the cutoff below leaves a
+ *  margin.
+ */
+
+//largest fraction of nonzeros in A for which the sparse path is used
+#define SPARSE_MAX_DENSITY 0.06
+
+void
+matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
+{
+  long nnz = 0;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) nnz += (a[i][j] != 0);
+  }
+  if (nnz <= SPARSE_MAX_DENSITY * n * n) {
+    CsrMatrix *s = csr_from_dense(n, n, &a[0][0], n);
+    csr_spmm(s, n, &b[0][0], n, &c[0][0], n);
+    sparse_free(s);
+  }
+  else {
+    gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, n, n, n, 1, &a[0][0], n, &b[0][0],
+         n, 0, &c[0][0], n);
+  }
+}
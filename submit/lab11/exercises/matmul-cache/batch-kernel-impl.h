@@ -0,0 +1,73 @@
+//Group kernels for batch-matmul.c: included once per instruction set,
+//with no include guard.  The includer defines
+//
+//  BK_TARGET           attributes of every kernel (e.g. its target)
+//  BK_MADD(acc, x, y)  acc += x * y for Lanes acc, x, y
+//  BK_NAME(f)          name of static function f for this instruction set
+//
+//all of which are #undef'd at the end.  Defines BK_NAME(multiply_n),
+//the kernel for any n, and BK_NAME(KERNELS)[n - 1], the kernels for
+//n <= BATCH_MAX_SPECIALIZED, with n a compile-time constant so that
+//loops bounded by n are unrolled and accumulators kept in registers.
+
+/** Multiply the n x n matrices of one group of a by those of b into c.
+ *  Each row of C is computed JB columns at a time, with a vector of
+ *  accumulators per column.
+ */
+BK_TARGET
+static inline __attribute__((always_inline)) void
+BK_NAME(multiply_group)(int n, const double *a, const double *b,
+                        double *c)
+{
+  for (int i = 0; i < n; i++) {
+    const double *ai = &a[i*n*L];
+    for (int j0 = 0; j0 < n; j0 += JB) {
+      const int jb = (n - j0 < JB) ? n - j0 : JB;
+      Lanes acc[JB];
+      #pragma GCC unroll 8
+      for (int jj = 0; jj < jb; jj++) acc[jj] = (Lanes){ 0 };
+      for (int k = 0; k < n; k++) {
+        Lanes aik;
+        load_lanes(&aik, &ai[k*L]);
+        const double *bk = &b[(k*n + j0)*L];
+        #pragma GCC unroll 8
+        for (int jj = 0; jj < jb; jj++) {
+          Lanes bkj;
+          load_lanes(&bkj, &bk[jj*L]);
+          BK_MADD(acc[jj], aik, bkj);
+        }
+      }
+      double *cij = &c[(i*n + j0)*L];
+      #pragma GCC unroll 8
+      for (int jj = 0; jj < jb; jj++) store_lanes(&cij[jj*L], &acc[jj]);
+    }
+  }
+}
+
+BK_TARGET
+static void
+BK_NAME(multiply_n)(int n, const double *a, const double *b, double *c)
+{
+  BK_NAME(multiply_group)(n, a, b, c);
+}
+
+#define BK_SPECIALIZE(N)                                                \
+  BK_TARGET                                                             \
+  static void                                                           \
+  BK_NAME(multiply_##N)(int n, const double *a, const double *b,        \
+                        double *c)                                      \
+  {                                                                     \
+    BK_NAME(multiply_group)(N, a, b, c);                                \
+  }
+BATCH_SIZES(BK_SPECIALIZE)
+#undef BK_SPECIALIZE
+
+#define BK_ENTRY(N) BK_NAME(multiply_##N),
+static GroupKernel *const BK_NAME(KERNELS)[BATCH_MAX_SPECIALIZED] = {
+  BATCH_SIZES(BK_ENTRY)
+};
+#undef BK_ENTRY
+
+#undef BK_TARGET
+#undef BK_MADD
+#undef BK_NAME
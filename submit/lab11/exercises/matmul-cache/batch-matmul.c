@@ -0,0 +1,135 @@
+#include "batch-matmul.h"
+#include "thread-pool.h"
+
+#include <string.h>
+
+#ifdef __x86_64__
+  #include <immintrin.h>
+#endif
+
+/** Each group of BATCH_LANES matrices is multiplied by a kernel which
+ *  treats a vector of BATCH_LANES doubles as a scalar, so that the
+ *  ordinary i-k-j loops multiply all the matrices of the group at once
+ *  with no shuffles.  There is one kernel per n <= BATCH_MAX_SPECIALIZED
+ *  and each comes in an AVX2/FMA and a portable version (see
+ *  batch-kernel-impl.h), the former used when the CPU supports it.
+ *  Runs of whole groups are spread over the thread pool.
+ */
+
+enum {
+  L = BATCH_LANES,
+  JB = 8,  //columns of C accumulated in registers
+};
+
+typedef double Lanes __attribute__((vector_size(L * sizeof(double))));
+
+//Lanes are passed by pointer: passing 32-byte vectors by value to
+//functions without AVX enabled changes the ABI
+static inline __attribute__((always_inline)) void
+load_lanes(Lanes *v, const double *p)
+{
+  memcpy(v, p, sizeof(*v));
+}
+
+static inline __attribute__((always_inline)) void
+store_lanes(double *p, const Lanes *v)
+{
+  memcpy(p, v, sizeof(*v));
+}
+
+typedef void GroupKernel(int n, const double *a, const double *b,
+                         double *c);
+
+//X(n) for every specialized size n
+#define BATCH_SIZES(X)                                                  \
+  X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8)                               \
+  X(9) X(10) X(11) X(12) X(13) X(14) X(15) X(16)                        \
+  X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24)                       \
+  X(25) X(26) X(27) X(28) X(29) X(30) X(31) X(32)
+
+//portable kernels
+#define BK_TARGET
+#define BK_MADD(acc, x, y) ((acc) += (x) * (y))
+#define BK_NAME(f) f##_c
+#include "batch-kernel-impl.h"
+
+#ifdef __x86_64__
+
+#define BK_TARGET __attribute__((target("avx2,fma")))
+#define BK_MADD(acc, x, y) \
+  ((acc) = (Lanes)_mm256_fmadd_pd((__m256d)(x), (__m256d)(y), \
+                                  (__m256d)(acc)))
+#define BK_NAME(f) f##_avx2
+#include "batch-kernel-impl.h"
+
+#endif //ifdef __x86_64__
+
+static GroupKernel *
+select_kernel(int n)
+{
+#ifdef __x86_64__
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return (n <= BATCH_MAX_SPECIALIZED) ? KERNELS_avx2[n - 1]
+      : multiply_n_avx2;
+  }
+#endif
+  return (n <= BATCH_MAX_SPECIALIZED) ? KERNELS_c[n - 1] : multiply_n_c;
+}
+
+size_t
+batch_matrix_size(int n, size_t count)
+{
+  return (count + L - 1) / L * L * n * n;
+}
+
+void
+batch_interleave(int n, size_t count, const double *mats, double *batch)
+{
+  const size_t nn = (size_t)n * n;
+  memset(batch, 0, batch_matrix_size(n, count) * sizeof(double));
+  for (size_t m = 0; m < count; m++) {
+    double *group = &batch[m / L * nn * L];
+    const double *mat = &mats[m * nn];
+    for (size_t e = 0; e < nn; e++) group[e*L + m%L] = mat[e];
+  }
+}
+
+void
+batch_deinterleave(int n, size_t count, const double *batch, double *mats)
+{
+  const size_t nn = (size_t)n * n;
+  for (size_t m = 0; m < count; m++) {
+    const double *group = &batch[m / L * nn * L];
+    double *mat = &mats[m * nn];
+    for (size_t e = 0; e < nn; e++) mat[e] = group[e*L + m%L];
+  }
+}
+
+typedef struct {
+  GroupKernel *kernel;
+  int n;
+  const double *a, *b;
+  double *c;
+} Job;
+
+static void
+multiply_groups(int begin, int end, int thread, void *arg)
+{
+  const Job *job = arg;
+  const size_t groupSize = (size_t)job->n * job->n * L;
+  for (int g = begin; g < end; g++) {
+    size_t offset = g * groupSize;
+    job->kernel(job->n, &job->a[offset], &job->b[offset], &job->c[offset]);
+  }
+}
+
+void
+batch_matrix_multiply(int n, size_t count, const double *a,
+                      const double *b, double *c)
+{
+  if (n <= 0 || count == 0) return;
+  Job job = { select_kernel(n), n, a, b, c };
+  int nGroups = (count + L - 1) / L;
+  parallel_for_work(nGroups, (double)count * n * n * n, multiply_groups,
+                    &job);
+}
@@ -0,0 +1,50 @@
+#ifndef _BATCH_MATMUL_H
+#define _BATCH_MATMUL_H
+
+#include <stddef.h>
+
+/** Multiplication of large batches of small n x n matrices.
+ *
+ *  A batch of count matrices is stored interleaved: the matrices are
+ *  split into groups of BATCH_LANES (the last group padded), and
+ *  within a group element (i, j) of all BATCH_LANES matrices is
+ *  contiguous, so that one SIMD vector holds the same element of every
+ *  matrix of the group.  That is, element (i, j) of matrix m is at
+ *
+ *    batch[(m/BATCH_LANES)*n*n*BATCH_LANES + (i*n + j)*BATCH_LANES
+ *          + m%BATCH_LANES]
+ *
+ *  and a batch needs batch_matrix_size(n, count) doubles.
+ */
+
+enum {
+  BATCH_LANES = 4,             //matrices per group: 1 AVX vector
+  BATCH_MAX_SPECIALIZED = 32,  //n <= this have unrolled kernels
+};
+
+/** Return the # of doubles in an interleaved batch of count n x n
+ *  matrices.
+ */
+size_t batch_matrix_size(int n, size_t count);
+
+/** Copy the count n x n matrices stored one after another in mats into
+ *  the interleaved batch, zeroing its padding.
+ */
+void batch_interleave(int n, size_t count, const double *mats,
+                      double *batch);
+
+/** Copy the count n x n matrices of the interleaved batch into mats,
+ *  one after another.
+ */
+void batch_deinterleave(int n, size_t count, const double *batch,
+                        double *mats);
+
+/** Set each matrix of the interleaved batch c to the product of the
+ *  corresponding matrices of the interleaved batches a and b.  Groups
+ *  are spread over the thread pool (see thread-pool.h).  c must not
+ *  overlap a or b.
+ */
+void batch_matrix_multiply(int n, size_t count, const double *a,
+                           const double *b, double *c);
+
+#endif //#ifndef _BATCH_MATMUL_H
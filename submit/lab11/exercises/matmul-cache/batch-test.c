@@ -0,0 +1,90 @@
+#define _XOPEN_SOURCE 1
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch-matmul.h"
+#include "matrix-util.h"
+
+/** Compare batch_matrix_multiply() with the classic algorithm applied
+ *  to each matrix, for every specialized size and a few larger ones,
+ *  with batch sizes which leave the last group partly empty and which
+ *  are split over several threads.  Also checks that interleaving and
+ *  deinterleaving a batch is the identity.
+ */
+
+static const size_t COUNTS[] = { 1, 3, 4, 5, 999 };
+
+static const int EXTRA_SIZES[] = { 33, 40 };
+
+/** Return 1 if the batch multiply of count n x n matrices passes,
+ *  printing the first error found.
+ */
+static int
+test_batch(int n, size_t count)
+{
+  const size_t nn = (size_t)n * n;
+  const size_t batchSize = batch_matrix_size(n, count);
+  double *a = must_malloc(count * nn * sizeof(double));
+  double *b = must_malloc(count * nn * sizeof(double));
+  double *c = must_malloc(count * nn * sizeof(double));
+  double *ref = must_malloc(nn * sizeof(double));
+  double *ia = must_malloc(batchSize * sizeof(double));
+  double *ib = must_malloc(batchSize * sizeof(double));
+  double *ic = must_malloc(batchSize * sizeof(double));
+  for (size_t e = 0; e < count * nn; e++) {
+    a[e] = 2*drand48() - 1;
+    b[e] = 2*drand48() - 1;
+  }
+  batch_interleave(n, count, a, ia);
+  batch_interleave(n, count, b, ib);
+  batch_matrix_multiply(n, count, ia, ib, ic);
+  batch_deinterleave(n, count, ic, c);
+
+  int isOk = 1;
+  //a round trip through the interleaved layout must not change a
+  double *roundTrip = must_malloc(count * nn * sizeof(double));
+  batch_deinterleave(n, count, ia, roundTrip);
+  if (memcmp(roundTrip, a, count * nn * sizeof(double)) != 0) {
+    printf("FAIL: n=%d count=%zu: deinterleave(interleave(a)) != a\n",
+           n, count);
+    isOk = 0;
+  }
+  free(roundTrip);
+  //relative to n max|A| max|B|, which is at most 1
+  const double bound = TEST_MAX_ERROR_EPS * DBL_EPSILON * n;
+  for (size_t m = 0; m < count && isOk; m++) {
+    classic_multiply(n, n, n, &a[m*nn], &b[m*nn], ref);
+    for (size_t e = 0; e < nn && isOk; e++) {
+      if (!(fabs(c[m*nn + e] - ref[e]) <= bound)) {
+        printf("FAIL: n=%d count=%zu: matrix %zu element (%zu, %zu) "
+               "= %.17g, expected %.17g\n", n, count, m, e / n, e % n,
+               c[m*nn + e], ref[e]);
+        isOk = 0;
+      }
+    }
+  }
+  free(a); free(b); free(c); free(ref);
+  free(ia); free(ib); free(ic);
+  return isOk;
+}
+
+int
+main(void)
+{
+  int nTests = 0, nFail = 0;
+  test_init();
+  const int nExtra = sizeof(EXTRA_SIZES)/sizeof(EXTRA_SIZES[0]);
+  for (int s = 0; s < BATCH_MAX_SPECIALIZED + nExtra; s++) {
+    int n = (s < BATCH_MAX_SPECIALIZED)
+      ? s + 1 : EXTRA_SIZES[s - BATCH_MAX_SPECIALIZED];
+    for (int t = 0; t < sizeof(COUNTS)/sizeof(COUNTS[0]); t++) {
+      nTests++;
+      nFail += !test_batch(n, COUNTS[t]);
+    }
+  }
+  return test_report("batch", nTests, nFail);
+}
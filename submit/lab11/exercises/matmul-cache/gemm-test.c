@@ -0,0 +1,208 @@
+#define _XOPEN_SOURCE 1
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gemm.h"
+#include "matrix-util.h"
+#include "packed-gemm.h"
+#include "tuning.h"
+
+/** Compare gemm(), sgemm() and mixed_gemm() with a direct evaluation
+ *  of their definition for every combination of transposes over shapes
+ *  which exercise partial micro-kernel tiles, several packed blocks and
+ *  bands, and strides larger than the # of columns.  Elements of C
+ *  outside the m x n matrix must not be changed.  For the float
+ *  variants, the inputs are rounded to float before the reference is
+ *  computed, and the error bound scales with the precision of C.
+ *
+ *  The tests are run with the heuristic tuning, and gemm() and
+ *  mixed_gemm() again for every kernel shape with blocks small enough
+ *  that every shape above spans several of them.
+ */
+
+//extra columns in each stored row
+enum { PAD = 3 };
+
+enum { MAX_KERNEL_SHAPES = 16 };
+
+//kc, and mc and nc in kernel blocks, for the kernel shape tests
+enum { SMALL_KC = 37, SMALL_MC_BLOCKS = 2, SMALL_NC_BLOCKS = 3 };
+
+static const struct {
+  int m, n, k;
+} SHAPES[] = {
+  { 1, 1, 1 }, { 5, 7, 3 }, { 13, 1, 17 }, { 1, 29, 300 },
+  { 67, 45, 0 }, { 100, 100, 100 }, { 150, 70, 530 }, { 301, 9, 64 },
+};
+
+static const struct {
+  double alpha, beta;
+} SCALES[] = {
+  { 1, 0 }, { 1, 1 }, { -0.5, 2 }, { 0, 0.5 }, { 3, -1 },
+};
+
+static double *
+random_matrix(int rows, int ld)
+{
+  double *x = must_malloc((size_t)rows * ld * sizeof(double));
+  random_fill(x, (long)rows * ld, 1);
+  return x;
+}
+
+typedef enum {
+  DOUBLE_GEMM,   //gemm()
+  FLOAT_GEMM,    //sgemm()
+  MIXED_GEMM,    //mixed_gemm()
+} GemmType;
+
+static const char *const TYPE_NAMES[] = { "gemm", "sgemm", "mixed_gemm" };
+
+static double
+op_get(GemmOp op, const double *x, int ld, int i, int j)
+{
+  return (op == GEMM_TRANS) ? x[(long)j*ld + i] : x[(long)i*ld + j];
+}
+
+/** Round the n doubles in x to float, returning float copies. */
+static float *
+to_float(double x[], long n)
+{
+  float *f = must_malloc((n > 0 ? n : 1) * sizeof(float));
+  for (long i = 0; i < n; i++) x[i] = f[i] = x[i];
+  return f;
+}
+
+/** Return 1 if the gemm() variant of the given type passes for the
+ *  given arguments, printing the first error found.
+ */
+static int
+test_gemm(GemmType type, GemmOp opA, GemmOp opB, int m, int n, int k,
+          double alpha, double beta)
+{
+  //stored shapes of A and B
+  int aRows = (opA == GEMM_TRANS) ? k : m;
+  int aCols = (opA == GEMM_TRANS) ? m : k;
+  int bRows = (opB == GEMM_TRANS) ? n : k;
+  int bCols = (opB == GEMM_TRANS) ? k : n;
+  int lda = aCols + PAD, ldb = bCols + PAD, ldc = n + PAD;
+  long aSize = (long)aRows * lda, bSize = (long)bRows * ldb;
+  long cSize = (long)m * ldc;
+  double *a = random_matrix(aRows > 0 ? aRows : 1, lda);
+  double *b = random_matrix(bRows > 0 ? bRows : 1, ldb);
+  double *c = random_matrix(m, ldc);
+  float *fa = NULL, *fb = NULL, *fc = NULL;
+  if (type != DOUBLE_GEMM) {
+    fa = to_float(a, aSize); fb = to_float(b, bSize);
+  }
+  if (type == FLOAT_GEMM) fc = to_float(c, cSize);
+  double *c0 = must_malloc(cSize * sizeof(double));
+  memcpy(c0, c, cSize * sizeof(double));
+  if (beta == 0) {
+    //must not be read
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        c[(long)i*ldc + j] = NAN;
+        if (fc) fc[(long)i*ldc + j] = NAN;
+      }
+    }
+  }
+  switch (type) {
+  case DOUBLE_GEMM:
+    gemm(opA, opB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    break;
+  case FLOAT_GEMM:
+    sgemm(opA, opB, m, n, k, alpha, fa, lda, fb, ldb, beta, fc, ldc);
+    for (long i = 0; i < cSize; i++) c[i] = fc[i];
+    break;
+  case MIXED_GEMM:
+    mixed_gemm(opA, opB, m, n, k, alpha, fa, lda, fb, ldb, beta, c, ldc);
+    break;
+  }
+
+  int isOk = 1;
+  double eps = (type == FLOAT_GEMM) ? FLT_EPSILON : DBL_EPSILON;
+  double bound = TEST_MAX_ERROR_EPS * eps * (k + 2) * (fabs(alpha) + 1) *
+    (fabs(beta) + 1);
+  for (int i = 0; i < m && isOk; i++) {
+    for (int j = 0; j < ldc && isOk; j++) {
+      double actual = c[(long)i*ldc + j];
+      double expected = c0[(long)i*ldc + j];
+      if (j < n) {
+        double sum = 0;
+        for (int p = 0; p < k; p++) {
+          sum += op_get(opA, a, lda, i, p) * op_get(opB, b, ldb, p, j);
+        }
+        expected = alpha*sum + (beta == 0 ? 0 : beta*expected);
+      }
+      if (!(fabs(actual - expected) <= bound)) {
+        printf("FAIL: %s op(A)=%s op(B)=%s m=%d n=%d k=%d alpha=%g "
+               "beta=%g: c[%d][%d] = %.17g, expected %.17g\n",
+               TYPE_NAMES[type], opA == GEMM_TRANS ? "A'" : "A",
+               opB == GEMM_TRANS ? "B'" : "B", m, n, k, alpha, beta, i, j,
+               actual, expected);
+        isOk = 0;
+      }
+    }
+  }
+  free(a); free(b); free(c); free(c0);
+  free(fa); free(fb); free(fc);
+  return isOk;
+}
+
+/** Run the tests for types [first, last], adding to *nTests and
+ *  *nFail.
+ */
+static void
+test_types(GemmType first, GemmType last, int *nTests, int *nFail)
+{
+  for (GemmType type = first; type <= last; type++) {
+    for (int s = 0; s < sizeof(SHAPES)/sizeof(SHAPES[0]); s++) {
+      for (int f = 0; f < sizeof(SCALES)/sizeof(SCALES[0]); f++) {
+        for (int op = 0; op < 4; op++) {
+          GemmOp opA = (op & 1) ? GEMM_TRANS : GEMM_NO_TRANS;
+          GemmOp opB = (op & 2) ? GEMM_TRANS : GEMM_NO_TRANS;
+          (*nTests)++;
+          *nFail += !test_gemm(type, opA, opB, SHAPES[s].m, SHAPES[s].n,
+                               SHAPES[s].k, SCALES[f].alpha,
+                               SCALES[f].beta);
+        }
+      }
+    }
+  }
+}
+
+int
+main(void)
+{
+  int nTests = 0, nFail = 0;
+  test_init();
+  Tuning tuning;
+  heuristic_tuning(&tuning);
+  set_tuning(&tuning);
+  test_types(DOUBLE_GEMM, MIXED_GEMM, &nTests, &nFail);
+
+  int shapes[MAX_KERNEL_SHAPES][2];
+  int nShapes = packed_kernel_shapes(shapes, MAX_KERNEL_SHAPES);
+  for (int s = 0; s < nShapes; s++) {
+    int mr = shapes[s][0], nr = shapes[s][1];
+    Tuning small = {
+      mr, nr, SMALL_MC_BLOCKS * mr, SMALL_KC, SMALL_NC_BLOCKS * nr, 0
+    };
+    set_tuning(&small);
+    PackedBlocking blocking;
+    packed_blocking(&blocking);
+    nTests++;
+    if (blocking.mr != mr || blocking.nr != nr) {
+      printf("FAIL: kernel shape %d x %d not selected\n", mr, nr);
+      nFail++;
+    }
+    //the float kernels have fixed blocks
+    test_types(DOUBLE_GEMM, DOUBLE_GEMM, &nTests, &nFail);
+    test_types(MIXED_GEMM, MIXED_GEMM, &nTests, &nFail);
+  }
+  return test_report("gemm", nTests, nFail);
+}
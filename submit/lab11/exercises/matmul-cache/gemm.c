@@ -0,0 +1,166 @@
+#include "gemm.h"
+#include "packed-gemm.h"
+#include "thread-pool.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** The rows of C are split into one contiguous band per thread of the
+ *  pool in thread-pool.c, in multiples of the micro-kernel height, and
+ *  the threads run packed_gemm_thread() (or its float or mixed variant)
+ *  together: each packs its own blocks of A into its own buffer, which
+ *  it allocates (and so first touches) itself, while each panel of B is
+ *  packed once, by all of them, into one buffer which they share.
+ *  Products too small to repay waking the pool are computed by the
+ *  caller alone.
+ */
+
+typedef enum {
+  DOUBLE_GEMM,   //gemm()
+  FLOAT_GEMM,    //sgemm()
+  MIXED_GEMM,    //mixed_gemm()
+} GemmType;
+
+typedef struct {
+  GemmType type;
+  GemmOp opA, opB;
+  int m, n, k;
+  double alpha, beta;
+  const void *a, *b;  //double or float
+  int lda, ldb;
+  void *c;            //float for FLOAT_GEMM, else double
+  int ldc;
+  int nThreads;       //# of parts the product is split into
+} Job;
+
+//packing buffers, allocated on first use: blocks of A by their thread
+static struct {
+  struct { double *d; float *s; } *a;   //per thread
+  double *b;                            //shared panel of B
+  float *sb;                            //shared panel of B for sgemm()
+} BUFFERS;
+
+static void *
+alloc_buffer(size_t size)
+{
+  void *buf = aligned_alloc(64, size);
+  if (!buf) {
+    fprintf(stderr, "could not malloc packing buffer: %s\n",
+            strerror(errno));
+    exit(1);
+  }
+  return buf;
+}
+
+static void
+alloc_buffer_table(void)
+{
+  if (!BUFFERS.a) {
+    BUFFERS.a = calloc(get_n_threads(), sizeof(BUFFERS.a[0]));
+    if (!BUFFERS.a) {
+      fprintf(stderr, "could not malloc buffer table: %s\n",
+              strerror(errno));
+      exit(1);
+    }
+  }
+}
+
+/** Compute part `part` of nParts of job, as thread `thread`. */
+static void
+multiply_part(const Job *job, int part, int nParts, int thread)
+{
+  if (job->type == FLOAT_GEMM) {
+    if (!BUFFERS.a[thread].s) {
+      BUFFERS.a[thread].s =
+        alloc_buffer(PACKED_SMC * PACKED_SKC * sizeof(float));
+    }
+    packed_sgemm_thread(job->opA, job->opB, job->m, job->n, job->k,
+                        job->alpha, job->a, job->lda, job->b, job->ldb,
+                        job->beta, job->c, job->ldc, BUFFERS.a[thread].s,
+                        BUFFERS.sb, part, nParts);
+    return;
+  }
+  if (!BUFFERS.a[thread].d) {
+    BUFFERS.a[thread].d =
+      alloc_buffer(PACKED_MAX_MC * PACKED_MAX_KC * sizeof(double));
+  }
+  if (job->type == MIXED_GEMM) {
+    packed_mixed_gemm_thread(job->opA, job->opB, job->m, job->n, job->k,
+                             job->alpha, job->a, job->lda, job->b,
+                             job->ldb, job->beta, job->c, job->ldc,
+                             BUFFERS.a[thread].d, BUFFERS.b, part, nParts);
+  }
+  else {
+    packed_gemm_thread(job->opA, job->opB, job->m, job->n, job->k,
+                       job->alpha, job->a, job->lda, job->b, job->ldb,
+                       job->beta, job->c, job->ldc, BUFFERS.a[thread].d,
+                       BUFFERS.b, part, nParts);
+  }
+}
+
+//parallel_for_work() over job->nThreads: each thread gets one part,
+//unless the caller runs them all as one
+static void
+run_parts(int begin, int end, int thread, void *arg)
+{
+  const Job *job = arg;
+  if (end - begin == 1) {
+    multiply_part(job, begin, job->nThreads, thread);
+  }
+  else {
+    multiply_part(job, 0, 1, thread);
+  }
+}
+
+static void
+run_job(Job *job)
+{
+  if (job->m <= 0 || job->n <= 0) return;
+  alloc_buffer_table();  //before starting workers
+  if (job->type == FLOAT_GEMM) {
+    if (!BUFFERS.sb) {
+      BUFFERS.sb = alloc_buffer(PACKED_SKC * PACKED_SNC * sizeof(float));
+    }
+  }
+  else if (!BUFFERS.b) {
+    BUFFERS.b = alloc_buffer(PACKED_MAX_KC * PACKED_MAX_NC * sizeof(double));
+  }
+  job->nThreads = get_n_threads();
+  parallel_for_work(job->nThreads, (double)job->m * job->n * job->k,
+                    run_parts, job);
+}
+
+void
+gemm(GemmOp opA, GemmOp opB, int m, int n, int k, double alpha,
+     const double *a, int lda, const double *b, int ldb,
+     double beta, double *c, int ldc)
+{
+  Job job = {
+    DOUBLE_GEMM, opA, opB, m, n, k, alpha, beta, a, b, lda, ldb, c, ldc
+  };
+  run_job(&job);
+}
+
+void
+sgemm(GemmOp opA, GemmOp opB, int m, int n, int k, float alpha,
+      const float *a, int lda, const float *b, int ldb,
+      float beta, float *c, int ldc)
+{
+  Job job = {
+    FLOAT_GEMM, opA, opB, m, n, k, alpha, beta, a, b, lda, ldb, c, ldc
+  };
+  run_job(&job);
+}
+
+void
+mixed_gemm(GemmOp opA, GemmOp opB, int m, int n, int k, double alpha,
+           const float *a, int lda, const float *b, int ldb,
+           double beta, double *c, int ldc)
+{
+  Job job = {
+    MIXED_GEMM, opA, opB, m, n, k, alpha, beta, a, b, lda, ldb, c, ldc
+  };
+  run_job(&job);
+}
@@ -0,0 +1,44 @@
+#ifndef _GEMM_H
+#define _GEMM_H
+
+/** General matrix multiply in the style of BLAS dgemm, for row-major
+ *  matrices.
+ */
+
+/** Whether gemm() uses a matrix as stored or its transpose. */
+typedef enum {
+  GEMM_NO_TRANS,
+  GEMM_TRANS,
+} GemmOp;
+
+/** Set C = alpha*op(A)*op(B) + beta*C, where op(X) is X or its
+ *  transpose as specified by opX, op(A) is m x k, op(B) is k x n and C
+ *  is m x n.  Each matrix is stored by rows with a row stride of lda,
+ *  ldb or ldc elements, which must be at least its # of columns as
+ *  stored, so that submatrices can be passed without copying.  When
+ *  beta is 0, C is not read, so it need not be initialized.  C must
+ *  not overlap A or B.
+ *
+ *  Rows of C are computed in parallel in the thread pool (see
+ *  thread-pool.h).
+ */
+void gemm(GemmOp opA, GemmOp opB, int m, int n, int k, double alpha,
+          const double *a, int lda, const double *b, int ldb,
+          double beta, double *c, int ldc);
+
+/** Single-precision gemm(): float kernels do twice the work of double
+ *  ones per instruction and halve the memory traffic.
+ */
+void sgemm(GemmOp opA, GemmOp opB, int m, int n, int k, float alpha,
+           const float *a, int lda, const float *b, int ldb,
+           float beta, float *c, int ldc);
+
+/** Mixed-precision gemm() for float A and B and double C: the products
+ *  are accumulated in double, so only the rounding of A and B to float
+ *  is lost.  Runs at the speed of gemm().
+ */
+void mixed_gemm(GemmOp opA, GemmOp opB, int m, int n, int k, double alpha,
+                const float *a, int lda, const float *b, int ldb,
+                double beta, double *c, int ldc);
+
+#endif //#ifndef _GEMM_H
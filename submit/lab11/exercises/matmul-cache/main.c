@@ -7,6 +7,20 @@
 
 #include "matmul.h"
 
+/** The driver of every X-matmul.  The Makefile compiles it a second
+ *  time with PARALLEL_MAIN defined, as parallel-main.o, for the targets
+ *  which multiply in the thread pool: only those take -t N_THREADS and
+ *  first touch the matrices in the pool (see first_touch() in
+ *  matrix-util.h), so that the serial targets never start it.
+ */
+#ifdef PARALLEL_MAIN
+  #include "matrix-util.h"
+  #include "thread-pool.h"
+  #define USAGE_THREADS "[-t N_THREADS] "
+#else
+  #define USAGE_THREADS ""
+#endif
+
 static void
 initMatrix(int n, double matrix[][n])
 {
@@ -31,15 +45,31 @@ out_matrix(int n, double a[][n])
 
 enum { MAX_TEST_MATRIX_SIZE = 6 };
 
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s " USAGE_THREADS "MATRIX_SIZE N_TRIALS\n",
+          prog);
+  exit(1);
+}
+
 int
 main(int argc, const char *argv[])
 {
   int matrixSize = -1;
   int numTests = -1;
-  if (argc != 3 || (matrixSize = atoi(argv[1])) <= 0 ||
-      (numTests = atoi(argv[2])) <= 0) {
-    fprintf(stderr, "usage: %s MATRIX_SIZE N_TRIALS\n", argv[0]);
-    exit(1);
+  int argBase = 1;
+#ifdef PARALLEL_MAIN
+  if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+    int nThreads = atoi(argv[2]);
+    if (nThreads <= 0) usage(argv[0]);
+    set_n_threads(nThreads);
+    argBase = 3;
+  }
+#endif
+  if (argc != argBase + 2 || (matrixSize = atoi(argv[argBase])) <= 0 ||
+      (numTests = atoi(argv[argBase + 1])) <= 0) {
+    usage(argv[0]);
   }
   int n = matrixSize;
   double (*a)[n] = malloc(sizeof(double[n][n]));
@@ -49,6 +79,11 @@ main(int argc, const char *argv[])
     fprintf(stderr, "could not malloc matrices: %s\n", strerror(errno));
     exit(1);
   }
+#ifdef PARALLEL_MAIN
+  first_touch(a, n, sizeof(a[0]));
+  first_touch(b, n, sizeof(b[0]));
+  first_touch(c, n, sizeof(c[0]));
+#endif
   initMatrix(n, a); initMatrix(n, b);
   for (int t = 0; t < numTests; t++) {
     matrix_multiply(n, a, b, c);
@@ -0,0 +1,320 @@
+#define _XOPEN_SOURCE 600  //for srand48()
+
+#include "gemm.h"
+#include "matrix-util.h"
+#include "thread-pool.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Benchmark for all implementations of matrix_multiply().  The
+ *  Makefile compiles each X-matmul.c a second time with
+ *  matrix_multiply renamed to X_matrix_multiply, so that all of them
+ *  can be linked into this one program and selected at run time.  The
+ *  float and mixed-precision variants of gemm() are also registered;
+ *  they are given A and B rounded to float.
+ *
+ *  For each matrix size n in a sweep, each selected implementation is
+ *  run N_WARMUP times and then timed over N_TRIALS trials, and the
+ *  median and best GFLOPS (2n^3 flops per multiply) are reported, as
+ *  a table or (with -j) as one JSON object per line.  The product of
+ *  the last trial is cross-checked against that of the simple kernel:
+ *  its normwise_error() (see matrix-util.h) must not exceed the
+ *  tolerance, else the exit status is 1.  For the
+ *  variants with float inputs, whose error is dominated by rounding
+ *  the inputs, the tolerance is scaled by FLT_EPSILON/DBL_EPSILON.
+ *
+ *  With -d, only about a fraction DENSITY of the elements of A are
+ *  nonzero, to compare the dense kernels with the sparse path of auto.
+ */
+
+typedef void MatmulFn(int n, double a[][n], double b[][n], double c[][n]);
+typedef void FloatMatmulFn(int n, float a[][n], float b[][n], float c[][n]);
+typedef void MixedMatmulFn(int n, float a[][n], float b[][n],
+                           double c[][n]);
+
+MatmulFn simple_matrix_multiply, transpose_matrix_multiply,
+  tiled_matrix_multiply, packed_matrix_multiply, parallel_matrix_multiply,
+  strassen_matrix_multiply, auto_matrix_multiply,
+  recursive_matrix_multiply;
+
+static void
+sgemm_multiply(int n, float a[][n], float b[][n], float c[][n])
+{
+  sgemm(GEMM_NO_TRANS, GEMM_NO_TRANS, n, n, n, 1, &a[0][0], n, &b[0][0], n,
+        0, &c[0][0], n);
+}
+
+static void
+mixed_multiply(int n, float a[][n], float b[][n], double c[][n])
+{
+  mixed_gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, n, n, n, 1, &a[0][0], n,
+             &b[0][0], n, 0, &c[0][0], n);
+}
+
+//exactly one of fn, floatFn and mixedFn is set
+static const struct {
+  const char *name;
+  MatmulFn *fn;
+  FloatMatmulFn *floatFn;
+  MixedMatmulFn *mixedFn;
+} IMPLS[] = {
+  { "simple", .fn = simple_matrix_multiply },
+  { "transpose", .fn = transpose_matrix_multiply },
+  { "tiled", .fn = tiled_matrix_multiply },
+  { "packed", .fn = packed_matrix_multiply },
+  { "parallel", .fn = parallel_matrix_multiply },
+  { "strassen", .fn = strassen_matrix_multiply },
+  { "auto", .fn = auto_matrix_multiply },
+  { "recursive", .fn = recursive_matrix_multiply },
+  { "sgemm", .floatFn = sgemm_multiply },
+  { "mixed", .mixedFn = mixed_multiply },
+};
+enum { N_IMPLS = sizeof(IMPLS)/sizeof(IMPLS[0]) };
+
+enum {
+  DEFAULT_N_TRIALS = 5,
+  DEFAULT_N_WARMUP = 1,
+};
+
+#define DEFAULT_TOLERANCE 1e-12
+
+/** Operands of one size, in double and (if needed) float. */
+typedef struct {
+  int n;
+  double *a, *b, *c;
+  float *fa, *fb, *fc;  //NULL if no float variant is selected
+} Operands;
+
+static void
+run_impl(int m, const Operands *ops)
+{
+  const int n = ops->n;
+  if (IMPLS[m].fn) {
+    IMPLS[m].fn(n, (double (*)[n])ops->a, (double (*)[n])ops->b,
+                (double (*)[n])ops->c);
+  }
+  else if (IMPLS[m].floatFn) {
+    IMPLS[m].floatFn(n, (float (*)[n])ops->fa, (float (*)[n])ops->fb,
+                     (float (*)[n])ops->fc);
+  }
+  else {
+    IMPLS[m].mixedFn(n, (float (*)[n])ops->fa, (float (*)[n])ops->fb,
+                     (double (*)[n])ops->c);
+  }
+}
+
+typedef struct {
+  double median, best;  //GFLOPS
+  double error;         //normwise relative error; NAN if not checked
+} Result;
+
+/** Run implementation m on ops nWarmup + nTrials times; secs[nTrials]
+ *  is scratch space.  If ref is not NULL, check the product against it.
+ */
+static Result
+bench_impl(int m, const Operands *ops, double ref[], int nWarmup,
+           int nTrials, double secs[])
+{
+  const int n = ops->n;
+  for (int w = 0; w < nWarmup; w++) run_impl(m, ops);
+  for (int t = 0; t < nTrials; t++) {
+    double t0 = now_secs();
+    run_impl(m, ops);
+    secs[t] = now_secs() - t0;
+  }
+  qsort(secs, nTrials, sizeof(secs[0]), compare_doubles);
+  double median = (nTrials % 2 != 0) ? secs[nTrials/2]
+    : (secs[nTrials/2 - 1] + secs[nTrials/2]) / 2;
+  double flops = 2.0 * n * n * (double)n;
+  Result result = { flops / median / 1e9, flops / secs[0] / 1e9, NAN };
+  if (ref) {
+    if (IMPLS[m].floatFn) {
+      for (long i = 0; i < (long)n * n; i++) ops->c[i] = ops->fc[i];
+    }
+    result.error = normwise_error(n, ops->a, ops->b, ops->c, ref);
+  }
+  return result;
+}
+
+/** Return a float copy of the n x n matrix x. */
+static float *
+to_float(int n, const double x[])
+{
+  float *f = must_malloc((size_t)n * n * sizeof(float));
+  first_touch(f, n, n * sizeof(float));
+  for (long i = 0; i < (long)n * n; i++) f[i] = x[i];
+  return f;
+}
+
+static void
+report(int isJson, const char *impl, int n, Result result, int nTrials,
+       int isBad)
+{
+  if (isJson) {
+    printf("{\"impl\": \"%s\", \"n\": %d, \"threads\": %d, "
+           "\"gflops_median\": %.4f, \"gflops_best\": %.4f, ",
+           impl, n, get_n_threads(), result.median, result.best);
+    if (isnan(result.error)) {
+      printf("\"error\": null, ");
+    }
+    else {
+      printf("\"error\": %.3e, ", result.error);
+    }
+    printf("\"n_trials\": %d, \"ok\": %s}\n", nTrials,
+           isBad ? "false" : "true");
+  }
+  else {
+    printf("%-10s n=%-5d %9.3f GFLOPS median %9.3f best", impl, n,
+           result.median, result.best);
+    if (!isnan(result.error)) printf("  error %.2e", result.error);
+    printf("%s\n", isBad ? "  FAIL" : "");
+  }
+}
+
+static void
+usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-j] [-x] [-i IMPL,...] [-r N_TRIALS] [-w N_WARMUP]\n"
+          "       [-t N_THREADS] [-e TOLERANCE] [-d DENSITY]\n"
+          "       MIN_SIZE [MAX_SIZE [STEP]]\n"
+          "sizes double from MIN_SIZE to MAX_SIZE unless STEP is given;\n"
+          "-x skips the check against simple; IMPL is one of:",
+          prog);
+  for (int i = 0; i < N_IMPLS; i++) fprintf(stderr, " %s", IMPLS[i].name);
+  fprintf(stderr, "\n");
+  exit(1);
+}
+
+/** Set isSelected[] from comma-separated list of implementation names. */
+static void
+select_impls(const char *prog, const char *list, int isSelected[])
+{
+  for (int i = 0; i < N_IMPLS; i++) isSelected[i] = 0;
+  while (*list != '\0') {
+    size_t len = strcspn(list, ",");
+    int i = 0;
+    while (i < N_IMPLS && !(strlen(IMPLS[i].name) == len &&
+                            strncmp(IMPLS[i].name, list, len) == 0)) {
+      i++;
+    }
+    if (i == N_IMPLS) usage(prog);
+    isSelected[i] = 1;
+    list += len + (list[len] == ',');
+  }
+}
+
+/** Return arg as an int >= min, exiting with usage if not valid. */
+static int
+parse_int(const char *prog, const char *arg, int min)
+{
+  char *end;
+  long n = strtol(arg, &end, 10);
+  if (*end != '\0' || n < min || n > 1L << 20) usage(prog);
+  return n;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int isJson = 0, isCheck = 1;
+  int nTrials = DEFAULT_N_TRIALS, nWarmup = DEFAULT_N_WARMUP;
+  double tolerance = DEFAULT_TOLERANCE, density = 1;
+  int isSelected[N_IMPLS];
+  for (int i = 0; i < N_IMPLS; i++) isSelected[i] = 1;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-j") == 0) {
+      isJson = 1;
+      continue;
+    }
+    if (strcmp(argv[i], "-x") == 0) {
+      isCheck = 0;
+      continue;
+    }
+    if (i + 1 >= argc) usage(argv[0]);
+    if (strcmp(argv[i], "-i") == 0) {
+      select_impls(argv[0], argv[++i], isSelected);
+    }
+    else if (strcmp(argv[i], "-r") == 0) {
+      nTrials = parse_int(argv[0], argv[++i], 1);
+    }
+    else if (strcmp(argv[i], "-w") == 0) {
+      nWarmup = parse_int(argv[0], argv[++i], 0);
+    }
+    else if (strcmp(argv[i], "-t") == 0) {
+      set_n_threads(parse_int(argv[0], argv[++i], 1));
+    }
+    else if (strcmp(argv[i], "-e") == 0) {
+      char *end;
+      tolerance = strtod(argv[++i], &end);
+      if (*end != '\0' || !(tolerance >= 0)) usage(argv[0]);
+    }
+    else if (strcmp(argv[i], "-d") == 0) {
+      char *end;
+      density = strtod(argv[++i], &end);
+      if (*end != '\0' || !(density >= 0 && density <= 1)) usage(argv[0]);
+    }
+    else {
+      usage(argv[0]);
+    }
+  }
+  int nArgs = argc - i;
+  if (nArgs < 1 || nArgs > 3) usage(argv[0]);
+  int minSize = parse_int(argv[0], argv[i], 1);
+  int maxSize = (nArgs > 1) ? parse_int(argv[0], argv[i + 1], 1) : minSize;
+  int step = (nArgs > 2) ? parse_int(argv[0], argv[i + 2], 1) : 0;
+  if (maxSize < minSize) usage(argv[0]);
+
+  int nBad = 0;
+  double *secs = must_malloc(nTrials * sizeof(double));
+  srand48(1);
+  int isFloat = 0;
+  for (int m = 0; m < N_IMPLS; m++) {
+    if (isSelected[m] && !IMPLS[m].fn) isFloat = 1;
+  }
+  for (int n = minSize; n <= maxSize; n = step ? n + step : 2*n) {
+    Operands ops = { n };
+    ops.a = must_malloc(sizeof(double[n][n]));
+    ops.b = must_malloc(sizeof(double[n][n]));
+    ops.c = must_malloc(sizeof(double[n][n]));
+    first_touch(ops.a, n, sizeof(double[n]));
+    first_touch(ops.b, n, sizeof(double[n]));
+    first_touch(ops.c, n, sizeof(double[n]));
+    double (*ref)[n] = NULL;
+    random_fill(ops.a, (long)n * n, density);
+    random_fill(ops.b, (long)n * n, 1);
+    if (isFloat) {
+      ops.fa = to_float(n, ops.a); ops.fb = to_float(n, ops.b);
+      ops.fc = to_float(n, ops.c);
+    }
+    if (isCheck) {
+      ref = must_malloc(sizeof(double[n][n]));
+      simple_matrix_multiply(n, (double (*)[n])ops.a, (double (*)[n])ops.b,
+                             ref);
+    }
+    for (int m = 0; m < N_IMPLS; m++) {
+      if (!isSelected[m]) continue;
+      Result result = bench_impl(m, &ops, (double *)ref, nWarmup, nTrials,
+                                 secs);
+      double limit = IMPLS[m].fn ? tolerance
+        : tolerance * (FLT_EPSILON / DBL_EPSILON);
+      int isBad = isCheck && !(result.error <= limit);
+      report(isJson, IMPLS[m].name, n, result, nTrials, isBad);
+      fflush(stdout);
+      nBad += isBad;
+    }
+    free(ops.a); free(ops.b); free(ops.c);
+    free(ops.fa); free(ops.fb); free(ops.fc);
+    free(ref);
+  }
+  free(secs);
+  if (nBad > 0) {
+    fprintf(stderr, "%d result(s) exceed tolerance %g\n", nBad, tolerance);
+  }
+  return nBad > 0;
+}
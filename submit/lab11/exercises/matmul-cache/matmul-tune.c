@@ -0,0 +1,267 @@
+#define _XOPEN_SOURCE 700  //for drand48(), fork()
+
+#include "gemm.h"
+#include "matrix-util.h"
+#include "packed-gemm.h"
+#include "thread-pool.h"
+#include "tuning.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** Find the tuning of tuning.h which makes gemm() fastest on this
+ *  machine and store it in the tuning file for this CPU, from which
+ *  every later program using packed_gemm() loads it.
+ *
+ *  Starting from the heuristic tuning, one parameter at a time is set
+ *  to each of its candidate values, keeping the fastest: first the #
+ *  of threads, then the kernel shape, kc, mc and nc, each search using
+ *  the best values found so far.  The thread pool cannot change its #
+ *  of threads once started, so each thread count is timed in a child
+ *  process.  Each candidate is timed by multiplying SIZE x SIZE
+ *  matrices N_TRIALS times after a warmup, using the median time.
+ */
+
+enum {
+  DEFAULT_SIZE = 1024,
+  DEFAULT_N_TRIALS = 3,
+  MAX_SHAPES = 16,
+  MAX_KEY = 64,
+};
+
+static const int KC_CANDIDATES[] = { 128, 192, 256, 320, 384, 448, 512 };
+
+//mc candidates, in multiples of mr
+static const int MC_BLOCKS[] = { 4, 8, 12, 16, 24, 32, 48, 64 };
+
+static const int NC_CANDIDATES[] = { 512, 1024, 2048, 3072, 4096 };
+
+#define N_ELEMS(array) ((int)(sizeof(array)/sizeof((array)[0])))
+
+typedef struct {
+  int n, nTrials;
+  double *a, *b, *c;
+  double *secs;   //nTrials
+} Bench;
+
+/** Return the median GFLOPS of gemm() with the current tuning. */
+static double
+time_gemm(const Bench *bench)
+{
+  const int n = bench->n;
+  for (int t = -1; t < bench->nTrials; t++) {
+    double start = now_secs();
+    gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, n, n, n, 1, bench->a, n, bench->b,
+         n, 0, bench->c, n);
+    if (t >= 0) bench->secs[t] = now_secs() - start;  //t = -1: warmup
+  }
+  qsort(bench->secs, bench->nTrials, sizeof(double), compare_doubles);
+  return 2.0 * n * n * n / bench->secs[bench->nTrials / 2] / 1e9;
+}
+
+static void
+print_tuning(const char *prefix, const Tuning *t, double gflops)
+{
+  printf("%s mr=%d nr=%d mc=%d kc=%d nc=%d threads=%d: %.3f GFLOPS\n",
+         prefix, t->mr, t->nr, t->mc, t->kc, t->nc, t->nThreads, gflops);
+  fflush(stdout);
+}
+
+/** Time gemm() with tuning *t in this process, replacing *best and
+ *  *bestGflops if it is faster.
+ */
+static void
+try_tuning(const Bench *bench, const Tuning *t, Tuning *best,
+           double *bestGflops)
+{
+  set_tuning(t);
+  double gflops = time_gemm(bench);
+  print_tuning("  ", t, gflops);
+  if (gflops > *bestGflops) {
+    *best = *t;
+    *bestGflops = gflops;
+  }
+}
+
+/** Return the GFLOPS of gemm() with tuning *t, timed in a child process
+ *  so that the thread pool can be started with t->nThreads threads.
+ */
+static double
+time_in_child(const Bench *bench, const Tuning *t)
+{
+  int fds[2];
+  if (pipe(fds) != 0) {
+    fprintf(stderr, "cannot create pipe: %s\n", strerror(errno));
+    exit(1);
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "cannot fork: %s\n", strerror(errno));
+    exit(1);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    set_n_threads(t->nThreads);
+    set_tuning(t);
+    double gflops = time_gemm(bench);
+    _exit(write(fds[1], &gflops, sizeof(gflops)) != sizeof(gflops));
+  }
+  close(fds[1]);
+  double gflops;
+  int isOk = read(fds[0], &gflops, sizeof(gflops)) == sizeof(gflops);
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  if (!isOk || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "timing with %d threads failed\n", t->nThreads);
+    exit(1);
+  }
+  return gflops;
+}
+
+/** Set best->nThreads to the fastest of 1, 2, 4, ... threads up to the
+ *  # of online CPUs, and that # itself.
+ */
+static void
+search_threads(const Bench *bench, Tuning *best, double *bestGflops)
+{
+  long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nCpus < 1) nCpus = 1;
+  for (long n = 1; ; n = (2*n < nCpus) ? 2*n : nCpus) {
+    Tuning t = *best;
+    t.nThreads = n;
+    double gflops = time_in_child(bench, &t);
+    print_tuning("  ", &t, gflops);
+    if (gflops > *bestGflops) {
+      *best = t;
+      *bestGflops = gflops;
+    }
+    if (n == nCpus) break;
+  }
+}
+
+/** Search the remaining parameters in this process, whose thread pool
+ *  must use best->nThreads threads.
+ */
+static void
+search_blocking(const Bench *bench, Tuning *best, double *bestGflops)
+{
+  int shapes[MAX_SHAPES][2];
+  int nShapes = packed_kernel_shapes(shapes, MAX_SHAPES);
+  Tuning start = *best;
+  for (int s = 0; s < nShapes; s++) {
+    Tuning t = start;
+    t.mr = shapes[s][0];
+    t.nr = shapes[s][1];
+    t.mc = t.mc / t.mr * t.mr;
+    t.nc = t.nc / t.nr * t.nr;
+    try_tuning(bench, &t, best, bestGflops);
+  }
+  start = *best;
+  for (int i = 0; i < N_ELEMS(KC_CANDIDATES); i++) {
+    Tuning t = start;
+    t.kc = KC_CANDIDATES[i];
+    try_tuning(bench, &t, best, bestGflops);
+  }
+  start = *best;
+  for (int i = 0; i < N_ELEMS(MC_BLOCKS); i++) {
+    Tuning t = start;
+    t.mc = MC_BLOCKS[i] * t.mr;
+    if (t.mc > PACKED_MAX_MC) break;
+    try_tuning(bench, &t, best, bestGflops);
+  }
+  start = *best;
+  for (int i = 0; i < N_ELEMS(NC_CANDIDATES); i++) {
+    Tuning t = start;
+    t.nc = NC_CANDIDATES[i] / t.nr * t.nr;
+    try_tuning(bench, &t, best, bestGflops);
+  }
+  set_tuning(best);
+}
+
+static void
+usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-n SIZE] [-r N_TRIALS] [-o FILE] [-p]\n"
+          "stores the tuning for this CPU in FILE, by default\n"
+          "$MATMUL_TUNING_FILE or ~/.matmul-tuning; -p only prints it\n",
+          prog);
+  exit(1);
+}
+
+/** Return arg as an int >= min, exiting with usage if not valid. */
+static int
+parse_int(const char *prog, const char *arg, int min)
+{
+  char *end;
+  long n = strtol(arg, &end, 10);
+  if (*end != '\0' || n < min || n > 1L << 16) usage(prog);
+  return n;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int n = DEFAULT_SIZE, nTrials = DEFAULT_N_TRIALS, isSave = 1;
+  const char *path = tuning_file_path();
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-p") == 0) {
+      isSave = 0;
+    }
+    else if (i + 1 >= argc) {
+      usage(argv[0]);
+    }
+    else if (strcmp(argv[i], "-n") == 0) {
+      n = parse_int(argv[0], argv[++i], 1);
+    }
+    else if (strcmp(argv[i], "-r") == 0) {
+      nTrials = parse_int(argv[0], argv[++i], 1);
+    }
+    else if (strcmp(argv[i], "-o") == 0) {
+      path = argv[++i];
+    }
+    else {
+      usage(argv[0]);
+    }
+  }
+  if (isSave && !path) usage(argv[0]);
+
+  char key[MAX_KEY];
+  tuning_cpu_key(key, sizeof(key));
+  printf("tuning for %s with %d x %d matrices\n", key, n, n);
+  Bench bench = { n, nTrials };
+  bench.a = must_malloc(sizeof(double[n][n]));
+  bench.b = must_malloc(sizeof(double[n][n]));
+  bench.c = must_malloc(sizeof(double[n][n]));
+  bench.secs = must_malloc(nTrials * sizeof(double));
+  srand48(1);
+  for (long e = 0; e < (long)n * n; e++) {
+    bench.a[e] = 2*drand48() - 1;
+    bench.b[e] = 2*drand48() - 1;
+  }
+
+  Tuning best;
+  heuristic_tuning(&best);
+  double bestGflops = 0;
+  search_threads(&bench, &best, &bestGflops);
+  set_n_threads(best.nThreads);
+  double heuristicGflops = bestGflops;
+  search_blocking(&bench, &best, &bestGflops);
+  print_tuning("best:", &best, bestGflops);
+  printf("%.2fx the heuristic blocking\n", bestGflops / heuristicGflops);
+  if (isSave) {
+    if (save_tuning(path, key, &best) != 0) {
+      fprintf(stderr, "cannot write %s: %s\n", path, strerror(errno));
+      return 1;
+    }
+    printf("saved in %s\n", path);
+  }
+  free(bench.a); free(bench.b); free(bench.c); free(bench.secs);
+  return 0;
+}
@@ -0,0 +1,112 @@
+#define _XOPEN_SOURCE 600  //for drand48(), clock_gettime()
+
+#include "matrix-util.h"
+#include "thread-pool.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *
+must_malloc(size_t size)
+{
+  void *p = malloc(size > 0 ? size : 1);
+  if (!p) {
+    fprintf(stderr, "cannot allocate %zu bytes: %s\n", size,
+            strerror(errno));
+    exit(1);
+  }
+  return p;
+}
+
+double
+now_secs(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1e9;
+}
+
+int
+compare_doubles(const void *p1, const void *p2)
+{
+  double d1 = *(const double *)p1, d2 = *(const double *)p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+typedef struct {
+  char *x;
+  size_t rowSize;
+} TouchJob;
+
+static void
+touch_rows(int begin, int end, int thread, void *arg)
+{
+  const TouchJob *job = arg;
+  memset(&job->x[begin * job->rowSize], 0, (end - begin) * job->rowSize);
+}
+
+void
+first_touch(void *x, int rows, size_t rowSize)
+{
+  TouchJob job = { x, rowSize };
+  parallel_for(rows, touch_rows, &job);
+}
+
+void
+random_fill(double x[], long n, double density)
+{
+  for (long i = 0; i < n; i++) {
+    x[i] = (density >= 1 || drand48() < density) ? 2*drand48() - 1 : 0;
+  }
+}
+
+static double
+max_abs(long n, const double x[])
+{
+  double max = 0;
+  for (long i = 0; i < n; i++) max = fmax(max, fabs(x[i]));
+  return max;
+}
+
+double
+normwise_error(int n, const double a[], const double b[],
+               const double c[], const double ref[])
+{
+  const long nn = (long)n * n;
+  double maxDiff = 0;
+  for (long i = 0; i < nn; i++) maxDiff = fmax(maxDiff, fabs(c[i] - ref[i]));
+  return maxDiff / (n * max_abs(nn, a) * max_abs(nn, b));
+}
+
+void
+classic_multiply(int m, int k, int n, const double a[], const double b[],
+                 double c[])
+{
+  for (int i = 0; i < m; i++) {
+    double *ci = &c[(long)i*n];
+    for (int j = 0; j < n; j++) ci[j] = 0;
+    for (int p = 0; p < k; p++) {
+      const double aip = a[(long)i*k + p];
+      const double *bp = &b[(long)p*n];
+      for (int j = 0; j < n; j++) ci[j] += aip*bp[j];
+    }
+  }
+}
+
+void
+test_init(void)
+{
+  srand48(1);
+  set_n_threads(TEST_N_THREADS);
+}
+
+int
+test_report(const char *name, int nTests, int nFail)
+{
+  printf("%s: %d of %d tests passed\n", name, nTests - nFail, nTests);
+  return nFail > 0;
+}
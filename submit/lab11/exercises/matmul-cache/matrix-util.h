@@ -0,0 +1,68 @@
+#ifndef _MATRIX_UTIL_H
+#define _MATRIX_UTIL_H
+
+/** Helpers shared by the tests, matmul-bench and matmul-tune, and
+ *  must_malloc() by sparse.c.
+ */
+
+#include <stddef.h>
+
+/** Return malloc(size), exiting with an error message if it fails. */
+void *must_malloc(size_t size);
+
+/** Return the time in seconds of a monotonic clock. */
+double now_secs(void);
+
+/** qsort() comparison of doubles in increasing order. */
+int compare_doubles(const void *p1, const void *p2);
+
+/** Zero the rows x rowSize bytes at x in the thread pool, a band of
+ *  rows per thread, so that each page is first touched, and so placed
+ *  on the NUMA node, by the thread which computes with those rows in
+ *  the parallel implementations.  Call it before filling x.
+ */
+void first_touch(void *x, int rows, size_t rowSize);
+
+/** Fill x[n] with uniform values from drand48() in [-1, 1), each being
+ *  nonzero with probability density (1 for a dense matrix).
+ */
+void random_fill(double x[], long n, double density);
+
+/** Return the normwise relative error of the n x n product c of the
+ *  n x n matrices a and b, against the product ref computed otherwise:
+ *
+ *    max |C - C_ref| / (n max |A| max |B|)
+ *
+ *  The classic algorithm is accurate elementwise, but fast algorithms
+ *  such as Strassen's only satisfy a bound on this error which grows
+ *  with their depth of recursion, so it is the error which all the
+ *  implementations can be held to.
+ */
+double normwise_error(int n, const double a[], const double b[],
+                      const double c[], const double ref[]);
+
+/** Set the m x n matrix c to the product of the m x k matrix a and the
+ *  k x n matrix b, all stored by rows without padding, with the classic
+ *  O(mnk) algorithm: the reference the tests compare with.
+ */
+void classic_multiply(int m, int k, int n, const double a[],
+                      const double b[], double c[]);
+
+/******************************** Tests ********************************/
+
+//# of threads of the tests: one which does not divide their sizes
+enum { TEST_N_THREADS = 3 };
+
+//error bound of the tests against classic_multiply(), in units of
+//epsilon of the result, relative to the inner dimension
+enum { TEST_MAX_ERROR_EPS = 4 };
+
+/** Start a test: seed drand48() and use TEST_N_THREADS threads. */
+void test_init(void);
+
+/** Print that nTests - nFail of the nTests tests of name passed, and
+ *  return the exit status of the test.
+ */
+int test_report(const char *name, int nTests, int nFail);
+
+#endif //#ifndef _MATRIX_UTIL_H
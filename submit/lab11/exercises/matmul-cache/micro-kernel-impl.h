@@ -0,0 +1,105 @@
+//Micro-kernels for packed-gemm.c: included once per element type and
+//instruction set, with no include guard.  The includer defines
+//
+//  MK_T                element type
+//  MK_VEC              vector type of MK_T used by the kernels
+//  MK_UVEC             MK_VEC aligned only as MK_T, for loads and stores
+//  MK_TARGET           attributes of every kernel (e.g. its target)
+//  MK_BROADCAST(x)     MK_VEC with every element x
+//  MK_MADD(acc, x, y)  acc += x * y for MK_VEC acc, x, y
+//  MK_SHAPE            type of the kernel table entries: { mr, nr, fn }
+//  MK_SHAPES(X)        X(MR, NV) for each kernel of MR rows by NV vectors
+//  MK_NAME(f)          name of static function f for this instantiation
+//
+//all of which are #undef'd at the end, and MAX_MR and MAX_NV, which
+//bound MR and NV.  Defines MK_NAME(KERNELS), the table of kernels in
+//the order of MK_SHAPES, each with MR and NV compile-time constants so
+//that loops bounded by them are unrolled and the accumulators kept in
+//registers.
+
+MK_TARGET
+static inline __attribute__((always_inline)) void
+MK_NAME(load)(MK_VEC *v, const MK_T *p)
+{
+  *v = *(const MK_UVEC *)p;
+}
+
+MK_TARGET
+static inline __attribute__((always_inline)) void
+MK_NAME(store)(MK_T *p, const MK_VEC *v)
+{
+  *(MK_UVEC *)p = *v;
+}
+
+/** c[mr x nv*W] (row stride ldc) = (isAccumulate ? c : 0) + ap * bp,
+ *  for W elements per vector.  The B row of each step is held in nv
+ *  registers and each element of the A column is broadcast in turn.
+ */
+MK_TARGET
+static inline __attribute__((always_inline)) void
+MK_NAME(kernel)(int mr, int nv, int kc, const MK_T *ap, const MK_T *bp,
+                MK_T *c, int ldc, int isAccumulate)
+{
+  const int w = sizeof(MK_VEC) / sizeof(MK_T);
+  MK_VEC acc[MAX_MR][MAX_NV];
+  #pragma GCC unroll 8
+  for (int i = 0; i < mr; i++) {
+    #pragma GCC unroll 4
+    for (int j = 0; j < nv; j++) acc[i][j] = (MK_VEC){ 0 };
+  }
+  for (int k = 0; k < kc; k++) {
+    MK_VEC b[MAX_NV];
+    #pragma GCC unroll 4
+    for (int j = 0; j < nv; j++) MK_NAME(load)(&b[j], &bp[j*w]);
+    #pragma GCC unroll 8
+    for (int i = 0; i < mr; i++) {
+      MK_VEC a = MK_BROADCAST(ap[i]);
+      #pragma GCC unroll 4
+      for (int j = 0; j < nv; j++) MK_MADD(acc[i][j], a, b[j]);
+    }
+    ap += mr; bp += nv*w;
+  }
+  #pragma GCC unroll 8
+  for (int i = 0; i < mr; i++) {
+    #pragma GCC unroll 4
+    for (int j = 0; j < nv; j++) {
+      MK_T *cij = &c[i*ldc + j*w];
+      MK_VEC cv = acc[i][j];
+      if (isAccumulate) {
+        MK_VEC old;
+        MK_NAME(load)(&old, cij);
+        cv += old;
+      }
+      MK_NAME(store)(cij, &cv);
+    }
+  }
+}
+
+#define MK_SPECIALIZE(MR, NV)                                           \
+  MK_TARGET                                                             \
+  static void                                                           \
+  MK_NAME(kernel_##MR##x##NV)(int kc, const MK_T *ap, const MK_T *bp,   \
+                              MK_T *c, int ldc, int isAccumulate)       \
+  {                                                                     \
+    MK_NAME(kernel)(MR, NV, kc, ap, bp, c, ldc, isAccumulate);          \
+  }
+MK_SHAPES(MK_SPECIALIZE)
+#undef MK_SPECIALIZE
+
+#define MK_ENTRY(MR, NV)                                                \
+  { MR, NV * (int)(sizeof(MK_VEC) / sizeof(MK_T)),                      \
+    MK_NAME(kernel_##MR##x##NV) },
+static const MK_SHAPE MK_NAME(KERNELS)[] = {
+  MK_SHAPES(MK_ENTRY)
+};
+#undef MK_ENTRY
+
+#undef MK_T
+#undef MK_VEC
+#undef MK_UVEC
+#undef MK_TARGET
+#undef MK_BROADCAST
+#undef MK_MADD
+#undef MK_SHAPE
+#undef MK_SHAPES
+#undef MK_NAME
@@ -0,0 +1,199 @@
+//Body of the packed GEMM driver: included by packed-gemm.c once per
+//precision, with no include guard.  The includer defines
+//
+//  PG_IN          element type of A and B
+//  PG_T           element type of the packed buffers, C, alpha and beta
+//  PG_BUFFERS     type of the packing buffers
+//  PG_BLOCKING    type of the kernel and block sizes (see Blocking in
+//                 packed-gemm.c)
+//  PG_SELECT      function setting a PG_BLOCKING for the CPU
+//  PG_NAME(f)     name of static function f for this precision
+//  PG_GEMM        name of the public driver
+//  PG_GEMM_THREAD name of its per-thread part
+//
+//all of which are #undef'd at the end.  Edge tiles are computed into a
+//buffer of MAX_MR x MAX_NR elements.
+
+/** Pack alpha times the mc x kc block of op(A) at a (row stride lda)
+ *  into ap as micro-panels of blk->mr rows: element (i, k) of a
+ *  micro-panel is at ap[k*blk->mr + i].
+ */
+static void
+PG_NAME(pack_a)(const PG_BLOCKING *blk, GemmOp op, const PG_IN *a,
+                int lda, int mc, int kc, PG_T alpha, PG_T *ap)
+{
+  const int fullMr = blk->mr;
+  for (int ir = 0; ir < mc; ir += fullMr) {
+    int mr = min(fullMr, mc - ir);
+    for (int k = 0; k < kc; k++) {
+      if (op == GEMM_TRANS) {
+        const PG_IN *ak = &a[(long)k*lda + ir];
+        for (int i = 0; i < mr; i++) ap[i] = alpha*(PG_T)ak[i];
+      }
+      else {
+        for (int i = 0; i < mr; i++) {
+          ap[i] = alpha*(PG_T)a[(long)(ir + i)*lda + k];
+        }
+      }
+      for (int i = mr; i < fullMr; i++) ap[i] = 0;
+      ap += fullMr;
+    }
+  }
+}
+
+/** Pack the kc x nc panel of op(B) at b (row stride ldb) into bp as
+ *  micro-panels of blk->nr columns: element (k, j) of a micro-panel is
+ *  at bp[k*blk->nr + j].
+ */
+static void
+PG_NAME(pack_b)(const PG_BLOCKING *blk, GemmOp op, const PG_IN *b,
+                int ldb, int kc, int nc, PG_T *bp)
+{
+  const int fullNr = blk->nr;
+  for (int jr = 0; jr < nc; jr += fullNr) {
+    int nr = min(fullNr, nc - jr);
+    if (op == GEMM_TRANS) {
+      //row j of B is column j of op(B)
+      for (int j = 0; j < nr; j++) {
+        const PG_IN *bj = &b[(long)(jr + j)*ldb];
+        for (int k = 0; k < kc; k++) bp[k*fullNr + j] = bj[k];
+      }
+      for (int j = nr; j < fullNr; j++) {
+        for (int k = 0; k < kc; k++) bp[k*fullNr + j] = 0;
+      }
+      bp += kc * fullNr;
+      continue;
+    }
+    for (int k = 0; k < kc; k++) {
+      const PG_IN *bk = &b[(long)k*ldb + jr];
+      if (nr == fullNr && sizeof(PG_IN) == sizeof(PG_T)) {
+        memcpy(bp, bk, fullNr * sizeof(PG_T));
+      }
+      else {
+        for (int j = 0; j < nr; j++) bp[j] = bk[j];
+        for (int j = nr; j < fullNr; j++) bp[j] = 0;
+      }
+      bp += fullNr;
+    }
+  }
+}
+
+/** Set the m x n matrix C at c (row stride ldc) to beta*C; if beta is 0
+ *  set it to 0 whatever its contents.
+ */
+static void
+PG_NAME(scale_c)(int m, int n, PG_T beta, PG_T *c, int ldc)
+{
+  if (beta == 1) return;
+  for (int i = 0; i < m; i++) {
+    PG_T *ci = &c[(long)i*ldc];
+    if (beta == 0) {
+      memset(ci, 0, n*sizeof(PG_T));
+    }
+    else {
+      for (int j = 0; j < n; j++) ci[j] *= beta;
+    }
+  }
+}
+
+/** Multiply the packed mc x kc block ap by the packed kc x nc panel
+ *  bp into the mc x nc block of C at c (row stride ldc).
+ */
+static void
+PG_NAME(multiply_packed)(const PG_BLOCKING *blk, PG_T *c, int ldc,
+                         int mc, int nc, int kc, const PG_T *ap,
+                         const PG_T *bp, int isAccumulate)
+{
+  const int fullMr = blk->mr, fullNr = blk->nr;
+  for (int jr = 0; jr < nc; jr += fullNr) {
+    int nr = min(fullNr, nc - jr);
+    for (int ir = 0; ir < mc; ir += fullMr) {
+      int mr = min(fullMr, mc - ir);
+      const PG_T *apr = &ap[ir * kc];
+      const PG_T *bpr = &bp[jr * kc];
+      if (mr == fullMr && nr == fullNr) {
+        blk->kernel(kc, apr, bpr, &c[(long)ir*ldc + jr], ldc,
+                    isAccumulate);
+      }
+      else {
+        //edge tile: compute full block into tmp, copy valid part
+        PG_T tmp[MAX_MR * MAX_NR];
+        blk->kernel(kc, apr, bpr, tmp, fullNr, 0);
+        for (int i = 0; i < mr; i++) {
+          PG_T *ci = &c[(long)(ir + i)*ldc + jr];
+          const PG_T *ti = &tmp[i*fullNr];
+          for (int j = 0; j < nr; j++) {
+            ci[j] = isAccumulate ? ci[j] + ti[j] : ti[j];
+          }
+        }
+      }
+    }
+  }
+}
+
+void
+PG_GEMM_THREAD(GemmOp opA, GemmOp opB, int m, int n, int k, PG_T alpha,
+               const PG_IN *a, int lda, const PG_IN *b, int ldb,
+               PG_T beta, PG_T *c, int ldc, PG_T *ap, PG_T *bp,
+               int thread, int nThreads)
+{
+  PG_BLOCKING blk;
+  PG_SELECT(&blk);
+  //this thread's band of rows, in whole micro-panels of A
+  int nBands = (m + blk.mr - 1) / blk.mr;
+  int i0Band = (long)nBands * thread / nThreads * blk.mr;
+  int i1Band = min(m, (long)nBands * (thread + 1) / nThreads * blk.mr);
+  int mBand = i1Band - i0Band;
+  PG_T *cBand = &c[(long)i0Band*ldc];
+  if (alpha == 0 || k == 0) {
+    PG_NAME(scale_c)(mBand, n, beta, cBand, ldc);
+    return;
+  }
+  //when beta is 0 the first panel of the product overwrites C
+  if (beta != 0) PG_NAME(scale_c)(mBand, n, beta, cBand, ldc);
+  for (int j0 = 0; j0 < n; j0 += blk.nc) {
+    int nc = min(blk.nc, n - j0);
+    int nPanels = (nc + blk.nr - 1) / blk.nr;
+    int p0 = (long)nPanels * thread / nThreads;
+    int p1 = (long)nPanels * (thread + 1) / nThreads;
+    for (int k0 = 0; k0 < k; k0 += blk.kc) {
+      int kc = min(blk.kc, k - k0);
+      //each thread packs its share of the micro-panels of B, once all
+      //the threads are done with the last panel
+      if (nThreads > 1) pool_barrier();
+      if (p0 < p1) {
+        int j1 = min(nc, p1 * blk.nr);
+        PG_NAME(pack_b)(&blk, opB,
+                        &b[op_offset(opB, ldb, k0, j0 + p0*blk.nr)], ldb,
+                        kc, j1 - p0*blk.nr, &bp[(long)p0*blk.nr*kc]);
+      }
+      if (nThreads > 1) pool_barrier();
+      for (int i0 = 0; i0 < mBand; i0 += blk.mc) {
+        int mc = min(blk.mc, mBand - i0);
+        PG_NAME(pack_a)(&blk, opA,
+                        &a[op_offset(opA, lda, i0Band + i0, k0)], lda,
+                        mc, kc, alpha, ap);
+        PG_NAME(multiply_packed)(&blk, &cBand[(long)i0*ldc + j0], ldc,
+                                 mc, nc, kc, ap, bp, k0 > 0 || beta != 0);
+      }
+    }
+  }
+}
+
+void
+PG_GEMM(GemmOp opA, GemmOp opB, int m, int n, int k, PG_T alpha,
+        const PG_IN *a, int lda, const PG_IN *b, int ldb,
+        PG_T beta, PG_T *c, int ldc, PG_BUFFERS *bufs)
+{
+  PG_GEMM_THREAD(opA, opB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc,
+                 bufs->a, bufs->b, 0, 1);
+}
+
+#undef PG_IN
+#undef PG_T
+#undef PG_BUFFERS
+#undef PG_BLOCKING
+#undef PG_SELECT
+#undef PG_NAME
+#undef PG_GEMM
+#undef PG_GEMM_THREAD
@@ -0,0 +1,281 @@
+#include "packed-gemm.h"
+#include "thread-pool.h"
+#include "tuning.h"
+
+#include <string.h>
+
+#ifdef __x86_64__
+  #include <immintrin.h>
+#endif
+
+/** C is computed in MR x NR blocks by a micro-kernel which keeps the
+ *  whole block in registers while it streams through a micro-panel of
+ *  A (MR rows) and of B (NR columns).  To make those streams
+ *  contiguous, the loops around the kernel pack
+ *
+ *    - a KC x NC panel of B (sized for the L3 cache) into bufs->b, as
+ *      KC x NR micro-panels, and
+ *    - an MC x KC block of A (sized for the L2 cache) into bufs->a, as
+ *      MR x KC micro-panels,
+ *
+ *  zero-padding partial micro-panels at the edges.  The kernel uses
+ *  AVX2/FMA when the CPU supports them and portable C otherwise.
+ *
+ *  For double, MR x NR is one of several kernel shapes and MC, KC and
+ *  NC are chosen at run time, from the tuning of tuning.h, since the
+ *  best ones depend on the CPU; the kernels of every shape are
+ *  instantiated from micro-kernel-impl.h.
+ *
+ *  The same driver, in packed-gemm-impl.h, is instantiated for double,
+ *  for float (with float kernels whose blocks are twice as wide, so
+ *  that each AVX instruction does twice the work) and for float inputs
+ *  with double accumulation (which converts while packing and then
+ *  uses the double kernels).
+ */
+
+//bounds of the kernel shapes, for accumulators and edge tiles
+enum {
+  MAX_MR = 8,
+  MAX_NV = 3,    //vectors per kernel row
+  MAX_NR = 16,   //MAX_NV vectors of double, 2 of float
+};
+
+enum {
+  SMR = PACKED_SMR,
+  SNR = PACKED_SNR,  //2 AVX vectors of float
+  SKC = PACKED_SKC,
+  SMC = PACKED_SMC,
+  SNC = PACKED_SNC,
+};
+
+static inline int
+min(int a, int b)
+{
+  return (a < b) ? a : b;
+}
+
+static inline int
+max(int a, int b)
+{
+  return (a > b) ? a : b;
+}
+
+/** Return offset of element (i, j) of op(X) from X with row stride
+ *  ldx.
+ */
+static inline long
+op_offset(GemmOp op, int ldx, int i, int j)
+{
+  return (op == GEMM_TRANS) ? (long)j*ldx + i : (long)i*ldx + j;
+}
+
+//c[mr x nr] (row stride ldc) = (isAccumulate ? c : 0) + ap * bp
+typedef void MicroKernel(int kc, const double *ap, const double *bp,
+                         double *c, int ldc, int isAccumulate);
+typedef void SMicroKernel(int kc, const float *ap, const float *bp,
+                          float *c, int ldc, int isAccumulate);
+
+typedef struct {
+  int mr, nr;
+  MicroKernel *fn;
+} KernelShape;
+
+typedef struct {
+  int mr, nr;
+  SMicroKernel *fn;
+} SKernelShape;
+
+//the kernel and blocks of one call of a packed driver
+typedef struct {
+  MicroKernel *kernel;
+  int mr, nr, mc, kc, nc;
+} Blocking;
+
+typedef struct {
+  SMicroKernel *kernel;
+  int mr, nr, mc, kc, nc;
+} SBlocking;
+
+//vectors of 4 doubles or 8 floats: one AVX register, two SSE ones
+typedef double Vec4d __attribute__((vector_size(32)));
+typedef float Vec8f __attribute__((vector_size(32)));
+typedef double Vec4dU __attribute__((vector_size(32), aligned(8)));
+typedef float Vec8fU __attribute__((vector_size(32), aligned(4)));
+
+/** Double kernel shapes, default first.  With AVX2 each uses at most
+ *  12 accumulators, so that with the row of B and the broadcast of A
+ *  all fit in the 16 registers.
+ */
+#define DOUBLE_SHAPES(X) X(6, 2) X(4, 3) X(8, 1) X(4, 2)
+
+#define FLOAT_SHAPES(X) X(6, 2)
+
+//portable kernels, which GCC compiles for whatever vector unit there is
+#define MK_T double
+#define MK_VEC Vec4d
+#define MK_UVEC Vec4dU
+#define MK_TARGET
+#define MK_BROADCAST(x) ((x) - (Vec4d){ 0 })
+#define MK_MADD(acc, x, y) ((acc) += (x) * (y))
+#define MK_SHAPE KernelShape
+#define MK_SHAPES DOUBLE_SHAPES
+#define MK_NAME(f) f##_c
+#include "micro-kernel-impl.h"
+
+#define MK_T float
+#define MK_VEC Vec8f
+#define MK_UVEC Vec8fU
+#define MK_TARGET
+#define MK_BROADCAST(x) ((x) - (Vec8f){ 0 })
+#define MK_MADD(acc, x, y) ((acc) += (x) * (y))
+#define MK_SHAPE SKernelShape
+#define MK_SHAPES FLOAT_SHAPES
+#define MK_NAME(f) f##_sc
+#include "micro-kernel-impl.h"
+
+#ifdef __x86_64__
+
+#define MK_T double
+#define MK_VEC Vec4d
+#define MK_UVEC Vec4dU
+#define MK_TARGET __attribute__((target("avx2,fma")))
+#define MK_BROADCAST(x) ((Vec4d)_mm256_set1_pd(x))
+#define MK_MADD(acc, x, y) \
+  ((acc) = (Vec4d)_mm256_fmadd_pd((__m256d)(x), (__m256d)(y), \
+                                  (__m256d)(acc)))
+#define MK_SHAPE KernelShape
+#define MK_SHAPES DOUBLE_SHAPES
+#define MK_NAME(f) f##_avx2
+#include "micro-kernel-impl.h"
+
+#define MK_T float
+#define MK_VEC Vec8f
+#define MK_UVEC Vec8fU
+#define MK_TARGET __attribute__((target("avx2,fma")))
+#define MK_BROADCAST(x) ((Vec8f)_mm256_set1_ps(x))
+#define MK_MADD(acc, x, y) \
+  ((acc) = (Vec8f)_mm256_fmadd_ps((__m256)(x), (__m256)(y), \
+                                  (__m256)(acc)))
+#define MK_SHAPE SKernelShape
+#define MK_SHAPES FLOAT_SHAPES
+#define MK_NAME(f) f##_savx2
+#include "micro-kernel-impl.h"
+
+#endif //ifdef __x86_64__
+
+static int
+has_avx2(void)
+{
+#ifdef __x86_64__
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  return 0;
+#endif
+}
+
+/** Set *shapes to the table of double kernels for this CPU, returning
+ *  its # of entries.
+ */
+static int
+kernel_table(const KernelShape **shapes)
+{
+#ifdef __x86_64__
+  if (has_avx2()) {
+    *shapes = KERNELS_avx2;
+    return sizeof(KERNELS_avx2)/sizeof(KERNELS_avx2[0]);
+  }
+#endif
+  *shapes = KERNELS_c;
+  return sizeof(KERNELS_c)/sizeof(KERNELS_c[0]);
+}
+
+int
+packed_kernel_shapes(int shapes[][2], int max)
+{
+  const KernelShape *table;
+  int n = min(kernel_table(&table), max);
+  for (int s = 0; s < n; s++) {
+    shapes[s][0] = table[s].mr;
+    shapes[s][1] = table[s].nr;
+  }
+  return n;
+}
+
+/** Return size reduced to at most maxSize and rounded down to a
+ *  multiple of unit, but at least unit.
+ */
+static int
+fit_block(int size, int unit, int maxSize)
+{
+  return max(unit, min(size, maxSize) / unit * unit);
+}
+
+static void
+select_blocking(Blocking *blk)
+{
+  const Tuning *t = get_tuning();
+  const KernelShape *shapes;
+  int nShapes = kernel_table(&shapes);
+  const KernelShape *shape = &shapes[0];
+  for (int s = 0; s < nShapes; s++) {
+    if (shapes[s].mr == t->mr && shapes[s].nr == t->nr) shape = &shapes[s];
+  }
+  blk->kernel = shape->fn;
+  blk->mr = shape->mr;
+  blk->nr = shape->nr;
+  blk->mc = fit_block(t->mc, blk->mr, PACKED_MAX_MC);
+  blk->kc = fit_block(t->kc, 1, PACKED_MAX_KC);
+  blk->nc = fit_block(t->nc, blk->nr, PACKED_MAX_NC);
+}
+
+void
+packed_blocking(PackedBlocking *blocking)
+{
+  Blocking blk;
+  select_blocking(&blk);
+  *blocking = (PackedBlocking){ blk.mr, blk.nr, blk.mc, blk.kc, blk.nc };
+}
+
+static void
+select_sblocking(SBlocking *blk)
+{
+  blk->kernel = has_avx2() ? KERNELS_savx2[0].fn : KERNELS_sc[0].fn;
+  blk->mr = SMR;
+  blk->nr = SNR;
+  blk->mc = SMC;
+  blk->kc = SKC;
+  blk->nc = SNC;
+}
+
+//packed_gemm(): double
+#define PG_IN double
+#define PG_T double
+#define PG_BUFFERS PackedBuffers
+#define PG_BLOCKING Blocking
+#define PG_SELECT select_blocking
+#define PG_NAME(f) f##_d
+#define PG_GEMM packed_gemm
+#define PG_GEMM_THREAD packed_gemm_thread
+#include "packed-gemm-impl.h"
+
+//packed_sgemm(): float
+#define PG_IN float
+#define PG_T float
+#define PG_BUFFERS PackedBuffersF
+#define PG_BLOCKING SBlocking
+#define PG_SELECT select_sblocking
+#define PG_NAME(f) f##_s
+#define PG_GEMM packed_sgemm
+#define PG_GEMM_THREAD packed_sgemm_thread
+#include "packed-gemm-impl.h"
+
+//packed_mixed_gemm(): float inputs, double packing and accumulation
+#define PG_IN float
+#define PG_T double
+#define PG_BUFFERS PackedBuffers
+#define PG_BLOCKING Blocking
+#define PG_SELECT select_blocking
+#define PG_NAME(f) f##_sd
+#define PG_GEMM packed_mixed_gemm
+#define PG_GEMM_THREAD packed_mixed_gemm_thread
+#include "packed-gemm-impl.h"
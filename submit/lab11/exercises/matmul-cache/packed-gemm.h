@@ -0,0 +1,115 @@
+#ifndef _PACKED_GEMM_H
+#define _PACKED_GEMM_H
+
+/** GotoBLAS-style packed matrix multiply shared by gemm() and the
+ *  packed and Strassen implementations of matrix_multiply().
+ */
+
+#include "gemm.h"
+
+//defaults for the double kernels, used when the cache sizes are unknown
+enum {
+  PACKED_MR = 6,                //rows of C computed by micro-kernel
+  PACKED_NR = 8,                //columns of C computed by micro-kernel
+  PACKED_KC = 256,              //depth of packed panels
+  PACKED_MC = 12 * PACKED_MR,   //rows of packed A block: fits in L2
+  PACKED_NC = 256 * PACKED_NR,  //columns of packed B panel: fits in L3
+};
+
+//largest tuned block sizes: those of PackedBuffers
+enum {
+  PACKED_MAX_MC = 384,
+  PACKED_MAX_KC = 512,
+  PACKED_MAX_NC = 4096,
+};
+
+//float blocks: same # of bytes per kernel row and packed panel
+enum {
+  PACKED_SMR = 6,
+  PACKED_SNR = 16,
+  PACKED_SKC = 2 * PACKED_KC,
+  PACKED_SMC = PACKED_MC,
+  PACKED_SNC = 128 * PACKED_SNR,
+};
+
+/** Buffers into which blocks of A and panels of B are packed.  Each
+ *  thread running packed_gemm() needs its own.  The *_thread() variants
+ *  below instead take the two separately.
+ */
+typedef struct {
+  double a[PACKED_MAX_MC * PACKED_MAX_KC] __attribute__((aligned(64)));
+  double b[PACKED_MAX_KC * PACKED_MAX_NC] __attribute__((aligned(64)));
+} PackedBuffers;
+
+/** Buffers for packed_sgemm(). */
+typedef struct {
+  float a[PACKED_SMC * PACKED_SKC] __attribute__((aligned(64)));
+  float b[PACKED_SKC * PACKED_SNC] __attribute__((aligned(64)));
+} PackedBuffersF;
+
+/** Kernel shape and block sizes of packed_gemm() and
+ *  packed_mixed_gemm(): those of get_tuning() in tuning.h, with the
+ *  kernel shape replaced by the default if it is not supported and the
+ *  blocks reduced to whole kernel blocks which fit in PackedBuffers.
+ *  The float blocks of packed_sgemm() are fixed.
+ */
+typedef struct {
+  int mr, nr, mc, kc, nc;
+} PackedBlocking;
+
+void packed_blocking(PackedBlocking *blocking);
+
+/** Set shapes[s] to { mr, nr } for each of the # of micro-kernel
+ *  shapes for this CPU returned, at most max; the first is the
+ *  default.
+ */
+int packed_kernel_shapes(int shapes[][2], int max);
+
+/** Single-threaded gemm() (see gemm.h), packing into bufs. */
+void packed_gemm(GemmOp opA, GemmOp opB, int m, int n, int k, double alpha,
+                 const double *a, int lda, const double *b, int ldb,
+                 double beta, double *c, int ldc, PackedBuffers *bufs);
+
+/** Single-threaded sgemm() (see gemm.h), packing into bufs. */
+void packed_sgemm(GemmOp opA, GemmOp opB, int m, int n, int k, float alpha,
+                  const float *a, int lda, const float *b, int ldb,
+                  float beta, float *c, int ldc, PackedBuffersF *bufs);
+
+/** Single-threaded mixed_gemm() (see gemm.h), packing into bufs. */
+void packed_mixed_gemm(GemmOp opA, GemmOp opB, int m, int n, int k,
+                       double alpha, const float *a, int lda,
+                       const float *b, int ldb, double beta, double *c,
+                       int ldc, PackedBuffers *bufs);
+
+/** Part `thread` of packed_gemm() run by nThreads threads, each calling
+ *  this from the fn of a parallel_for() over nThreads (see
+ *  thread-pool.h) with its own part.  Each thread computes a band of the
+ *  rows of C, packing its blocks of A into its own ap of PACKED_MAX_MC *
+ *  PACKED_MAX_KC elements, while all the threads pack each panel of B
+ *  together into bp of PACKED_MAX_KC * PACKED_MAX_NC elements, shared by
+ *  them, waiting for each other with pool_barrier().  With nThreads 1
+ *  this is packed_gemm() itself, and need not run in the pool.
+ */
+void packed_gemm_thread(GemmOp opA, GemmOp opB, int m, int n, int k,
+                        double alpha, const double *a, int lda,
+                        const double *b, int ldb, double beta, double *c,
+                        int ldc, double *ap, double *bp,
+                        int thread, int nThreads);
+
+/** Part of packed_sgemm() as packed_gemm_thread(), with ap of
+ *  PACKED_SMC * PACKED_SKC and bp of PACKED_SKC * PACKED_SNC elements.
+ */
+void packed_sgemm_thread(GemmOp opA, GemmOp opB, int m, int n, int k,
+                         float alpha, const float *a, int lda,
+                         const float *b, int ldb, float beta, float *c,
+                         int ldc, float *ap, float *bp,
+                         int thread, int nThreads);
+
+/** Part of packed_mixed_gemm() as packed_gemm_thread(). */
+void packed_mixed_gemm_thread(GemmOp opA, GemmOp opB, int m, int n, int k,
+                              double alpha, const float *a, int lda,
+                              const float *b, int ldb, double beta,
+                              double *c, int ldc, double *ap, double *bp,
+                              int thread, int nThreads);
+
+#endif //#ifndef _PACKED_GEMM_H
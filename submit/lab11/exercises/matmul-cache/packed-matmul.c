@@ -0,0 +1,12 @@
+#include "matmul.h"
+#include "packed-gemm.h"
+
+//static so that no memory is allocated per call
+static PackedBuffers BUFFERS;
+
+void
+matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
+{
+  packed_gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, n, n, n, 1, &a[0][0], n,
+              &b[0][0], n, 0, &c[0][0], n, &BUFFERS);
+}
@@ -0,0 +1,14 @@
+#include "matmul.h"
+#include "gemm.h"
+
+/** Multithreaded packed matrix multiply: a thin wrapper around gemm(),
+ *  which splits the rows of C among the threads of the pool in
+ *  thread-pool.c.
+ */
+
+void
+matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
+{
+  gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, n, n, n, 1, &a[0][0], n, &b[0][0], n,
+       0, &c[0][0], n);
+}
@@ -0,0 +1,72 @@
+#include "matmul.h"
+#include "packed-gemm.h"
+
+/** Cache-oblivious matrix multiply.  C = A B is split in half along
+ *  its largest dimension of m, n and k, recursively, so that at some
+ *  depth the three blocks of every subproblem fit in each level of
+ *  cache, whatever its size; no block size is tuned for the machine.
+ *  Splitting k turns the second half into C += A2 B2.
+ *
+ *  Once all three dimensions are at most BASE, the subproblem is done
+ *  by packed_gemm(), whose SIMD micro-kernel needs its operands packed.
+ *  Each base case packs its blocks afresh, so BASE must be large
+ *  enough for packing O(BASE^2) elements to be cheap next to the
+ *  O(BASE^3) flops; the blocks of A and B then fit in L2 on any current
+ *  CPU.  At n = 512..2048 this runs at 85-90% of packed-matmul.
+ */
+
+enum {
+  BASE = 160,
+  ALIGN = 24,  //split points are multiples of this: whole kernel blocks
+};
+
+//static so that no memory is allocated per call
+static PackedBuffers BUFFERS;
+
+/** Return where to split size > BASE: its middle, rounded up to a
+ *  multiple of ALIGN, so that only the last base case along each
+ *  dimension has partial kernel blocks.
+ */
+static int
+split(int size)
+{
+  return (size / 2 + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+/** Set the m x n matrix c = (isAccumulate ? c : 0) + a b, for a m x k
+ *  and b k x n, with row strides lda, ldb and ldc.
+ */
+static void
+recursive_multiply(int m, int n, int k, const double *a, int lda,
+                   const double *b, int ldb, double *c, int ldc,
+                   int isAccumulate)
+{
+  if (m <= BASE && n <= BASE && k <= BASE) {
+    packed_gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, m, n, k, 1, a, lda, b, ldb,
+                isAccumulate, c, ldc, &BUFFERS);
+  }
+  else if (m >= n && m >= k) {
+    int h = split(m);
+    recursive_multiply(h, n, k, a, lda, b, ldb, c, ldc, isAccumulate);
+    recursive_multiply(m - h, n, k, &a[(long)h*lda], lda, b, ldb,
+                       &c[(long)h*ldc], ldc, isAccumulate);
+  }
+  else if (n >= k) {
+    int h = split(n);
+    recursive_multiply(m, h, k, a, lda, b, ldb, c, ldc, isAccumulate);
+    recursive_multiply(m, n - h, k, a, lda, &b[h], ldb, &c[h], ldc,
+                       isAccumulate);
+  }
+  else {
+    int h = split(k);
+    recursive_multiply(m, n, h, a, lda, b, ldb, c, ldc, isAccumulate);
+    recursive_multiply(m, n, k - h, &a[h], lda, &b[(long)h*ldb], ldb, c,
+                       ldc, 1);
+  }
+}
+
+void
+matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
+{
+  recursive_multiply(n, n, n, &a[0][0], n, &b[0][0], n, &c[0][0], n, 0);
+}
@@ -0,0 +1,135 @@
+#define _XOPEN_SOURCE 1
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sparse.h"
+#include "matrix-util.h"
+
+/** Check the sparse formats and products against dense computations on
+ *  random matrices of several shapes and densities: conversions must
+ *  round-trip exactly and keep indices sorted, and SpMV, SpMM and
+ *  SpGEMM must agree with the classic algorithm.
+ */
+
+static const struct {
+  int m, k, n;
+  double density;
+} CASES[] = {
+  { 1, 1, 1, 1 }, { 7, 5, 3, 0.5 }, { 40, 60, 50, 0 }, { 64, 64, 64, 0.05 },
+  { 100, 80, 120, 0.2 }, { 300, 200, 250, 0.02 }, { 257, 513, 129, 0.9 },
+};
+
+/** Return a random rows x cols matrix with about density nonzeros. */
+static double *
+random_sparse(int rows, int cols, double density)
+{
+  double *x = must_malloc((size_t)rows * cols * sizeof(double));
+  random_fill(x, (long)rows * cols, density);
+  return x;
+}
+
+/** Return 1 if the count doubles in x and y differ by at most bound,
+ *  else print the first difference and return 0.
+ */
+static int
+check_close(const char *what, long count, const double *x,
+            const double *y, double bound)
+{
+  for (long e = 0; e < count; e++) {
+    if (!(fabs(x[e] - y[e]) <= bound)) {
+      printf("FAIL: %s: element %ld = %.17g, expected %.17g\n", what, e,
+             x[e], y[e]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/** Return 1 if the outer vectors of a have increasing inner indices. */
+static int
+check_sorted(const char *what, const SparseMatrix *a, int nOuter)
+{
+  for (int o = 0; o < nOuter; o++) {
+    for (int p = a->ptr[o] + 1; p < a->ptr[o + 1]; p++) {
+      if (a->idx[p - 1] >= a->idx[p]) {
+        printf("FAIL: %s: indices of vector %d not increasing\n", what, o);
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/** Return 1 if all checks pass for A m x k and B k x n, printing each
+ *  failure.
+ */
+static int
+test_case(int m, int k, int n, double density)
+{
+  int nFail = 0;
+  double *a = random_sparse(m, k, density);
+  double *b = random_sparse(k, n, density);
+  double *ref = must_malloc((size_t)m * n * sizeof(double));
+  double *out = must_malloc((size_t)m * (n > k ? n : k) * sizeof(double));
+  classic_multiply(m, k, n, a, b, ref);
+  const double bound = TEST_MAX_ERROR_EPS * DBL_EPSILON * k;
+
+  //conversions
+  CsrMatrix *csr = csr_from_dense(m, k, a, k);
+  CscMatrix *csc = csc_from_dense(m, k, a, k);
+  CsrMatrix *back = csc_to_csr(csc);
+  nFail += !check_sorted("csr_from_dense", csr, m);
+  nFail += !check_sorted("csc_from_dense", csc, k);
+  nFail += !check_sorted("csc_to_csr", back, m);
+  csr_to_dense(csr, out, k);
+  nFail += !check_close("csr_to_dense(csr_from_dense)", (long)m*k, out, a, 0);
+  csr_to_dense(back, out, k);
+  nFail += !check_close("csc_to_csr(csc_from_dense)", (long)m*k, out, a, 0);
+
+  //SpMV: the first column of B as x
+  double *x = must_malloc(k * sizeof(double));
+  double *y = must_malloc(m * sizeof(double));
+  double *yRef = must_malloc(m * sizeof(double));
+  for (int p = 0; p < k; p++) x[p] = b[(long)p*n];
+  for (int i = 0; i < m; i++) yRef[i] = ref[(long)i*n];
+  csr_spmv(csr, x, y);
+  nFail += !check_close("csr_spmv", m, y, yRef, bound);
+  csc_spmv(csc, x, y);
+  nFail += !check_close("csc_spmv", m, y, yRef, bound);
+
+  //SpMM
+  csr_spmm(csr, n, b, n, out, n);
+  nFail += !check_close("csr_spmm", (long)m*n, out, ref, bound);
+
+  //SpGEMM
+  CsrMatrix *bCsr = csr_from_dense(k, n, b, n);
+  CsrMatrix *c = csr_spgemm(csr, bCsr);
+  nFail += !check_sorted("csr_spgemm", c, m);
+  csr_to_dense(c, out, n);
+  nFail += !check_close("csr_spgemm", (long)m*n, out, ref, bound);
+
+  sparse_free(csr); sparse_free(csc); sparse_free(back);
+  sparse_free(bCsr); sparse_free(c);
+  free(a); free(b); free(ref); free(out); free(x); free(y); free(yRef);
+  if (nFail > 0) {
+    printf("FAIL: m=%d k=%d n=%d density=%g: %d check(s) failed\n",
+           m, k, n, density, nFail);
+  }
+  return nFail == 0;
+}
+
+int
+main(void)
+{
+  int nFail = 0;
+  const int nCases = sizeof(CASES)/sizeof(CASES[0]);
+  test_init();
+  for (int t = 0; t < nCases; t++) {
+    nFail += !test_case(CASES[t].m, CASES[t].k, CASES[t].n,
+                        CASES[t].density);
+  }
+  return test_report("sparse", nCases, nFail);
+}
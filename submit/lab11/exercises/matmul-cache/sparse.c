@@ -0,0 +1,370 @@
+#include "sparse.h"
+#include "matrix-util.h"
+#include "thread-pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** CSR and CSC matrices share one representation, so conversions
+ *  between them are transpositions of the compressed arrays.  SpMM and
+ *  SpGEMM split rows of the result over the thread pool.  SpGEMM is
+ *  Gustavson's row-by-row algorithm in two passes over the rows: the
+ *  first counts the nonzeros of each row of the product, so that the
+ *  second can write each row directly into its final place.  Both
+ *  passes accumulate a row in a per-thread open-addressing hash table
+ *  keyed by column, sized for the # of products contributing to the
+ *  row.
+ */
+
+//smallest SpGEMM hash table
+enum { MIN_HASH_BITS = 4, MIN_HASH_SIZE = 1 << MIN_HASH_BITS };
+
+/** Return a matrix with nPtr + 1 pointers, all 0, and room for nnz
+ *  nonzeros.
+ */
+static SparseMatrix *
+new_sparse(int nRows, int nCols, int nPtr, int nnz)
+{
+  SparseMatrix *a = must_malloc(sizeof(SparseMatrix));
+  a->nRows = nRows; a->nCols = nCols; a->nnz = nnz;
+  a->ptr = must_malloc((nPtr + 1) * sizeof(int));
+  memset(a->ptr, 0, (nPtr + 1) * sizeof(int));
+  a->idx = must_malloc(nnz * sizeof(int));
+  a->val = must_malloc(nnz * sizeof(double));
+  return a;
+}
+
+/** Convert counts[0, n) in ptr[1, n] to the prefix sums ptr[0, n]. */
+static void
+counts_to_ptr(int n, int ptr[])
+{
+  ptr[0] = 0;
+  for (int i = 0; i < n; i++) ptr[i + 1] += ptr[i];
+}
+
+void
+sparse_free(SparseMatrix *a)
+{
+  if (a) {
+    free(a->ptr); free(a->idx); free(a->val);
+    free(a);
+  }
+}
+
+CsrMatrix *
+csr_from_dense(int nRows, int nCols, const double *a, int lda)
+{
+  int nnz = 0;
+  for (int i = 0; i < nRows; i++) {
+    const double *ai = &a[(long)i*lda];
+    for (int j = 0; j < nCols; j++) nnz += (ai[j] != 0);
+  }
+  CsrMatrix *s = new_sparse(nRows, nCols, nRows, nnz);
+  int p = 0;
+  for (int i = 0; i < nRows; i++) {
+    const double *ai = &a[(long)i*lda];
+    for (int j = 0; j < nCols; j++) {
+      if (ai[j] != 0) {
+        s->idx[p] = j; s->val[p] = ai[j];
+        p++;
+      }
+    }
+    s->ptr[i + 1] = p;
+  }
+  return s;
+}
+
+/** Return the compressed arrays of a, with nOuter pointers and inner
+ *  indices in [0, nInner), transposed: the result has nInner pointers
+ *  and inner indices in [0, nOuter), in increasing order.
+ */
+static SparseMatrix *
+transpose_compressed(const SparseMatrix *a, int nOuter, int nInner)
+{
+  const int nnz = a->nnz;
+  SparseMatrix *t = new_sparse(a->nRows, a->nCols, nInner, nnz);
+  for (int p = 0; p < nnz; p++) t->ptr[a->idx[p] + 1]++;
+  counts_to_ptr(nInner, t->ptr);
+  //next free position in each inner vector; outer vectors are visited
+  //in order so that the new inner indices are increasing
+  int *next = must_malloc(nInner * sizeof(int));
+  memcpy(next, t->ptr, nInner * sizeof(int));
+  for (int o = 0; o < nOuter; o++) {
+    for (int p = a->ptr[o]; p < a->ptr[o + 1]; p++) {
+      int q = next[a->idx[p]]++;
+      t->idx[q] = o; t->val[q] = a->val[p];
+    }
+  }
+  free(next);
+  return t;
+}
+
+CscMatrix *
+csr_to_csc(const CsrMatrix *a)
+{
+  return transpose_compressed(a, a->nRows, a->nCols);
+}
+
+CsrMatrix *
+csc_to_csr(const CscMatrix *a)
+{
+  return transpose_compressed(a, a->nCols, a->nRows);
+}
+
+CscMatrix *
+csc_from_dense(int nRows, int nCols, const double *a, int lda)
+{
+  CsrMatrix *csr = csr_from_dense(nRows, nCols, a, lda);
+  CscMatrix *csc = csr_to_csc(csr);
+  sparse_free(csr);
+  return csc;
+}
+
+void
+csr_to_dense(const CsrMatrix *a, double *d, int ldd)
+{
+  for (int i = 0; i < a->nRows; i++) {
+    double *di = &d[(long)i*ldd];
+    memset(di, 0, a->nCols * sizeof(double));
+    for (int p = a->ptr[i]; p < a->ptr[i + 1]; p++) {
+      di[a->idx[p]] = a->val[p];
+    }
+  }
+}
+
+void
+csr_spmv(const CsrMatrix *a, const double *x, double *y)
+{
+  for (int i = 0; i < a->nRows; i++) {
+    double sum = 0;
+    for (int p = a->ptr[i]; p < a->ptr[i + 1]; p++) {
+      sum += a->val[p] * x[a->idx[p]];
+    }
+    y[i] = sum;
+  }
+}
+
+void
+csc_spmv(const CscMatrix *a, const double *x, double *y)
+{
+  memset(y, 0, a->nRows * sizeof(double));
+  for (int j = 0; j < a->nCols; j++) {
+    const double xj = x[j];
+    for (int p = a->ptr[j]; p < a->ptr[j + 1]; p++) {
+      y[a->idx[p]] += a->val[p] * xj;
+    }
+  }
+}
+
+typedef struct {
+  const CsrMatrix *a;
+  int n;
+  const double *b;
+  int ldb;
+  double *c;
+  int ldc;
+} SpmmJob;
+
+static void
+spmm_rows(int begin, int end, int thread, void *arg)
+{
+  const SpmmJob *job = arg;
+  const CsrMatrix *a = job->a;
+  const int n = job->n;
+  for (int i = begin; i < end; i++) {
+    double *restrict ci = &job->c[(long)i*job->ldc];
+    memset(ci, 0, n * sizeof(double));
+    for (int p = a->ptr[i]; p < a->ptr[i + 1]; p++) {
+      const double aik = a->val[p];
+      const double *restrict bk = &job->b[(long)a->idx[p]*job->ldb];
+      for (int j = 0; j < n; j++) ci[j] += aik*bk[j];
+    }
+  }
+}
+
+void
+csr_spmm(const CsrMatrix *a, int n, const double *b, int ldb,
+         double *c, int ldc)
+{
+  SpmmJob job = { a, n, b, ldb, c, ldc };
+  parallel_for_work(a->nRows, (double)a->nnz * n, spmm_rows, &job);
+}
+
+/** Per-thread accumulator for one row of an SpGEMM product. */
+typedef struct {
+  int size;      //power of 2
+  int shift;     //32 - log2(size)
+  int *keys;     //column, or -1 if empty
+  double *vals;
+  int *used;     //slots in use, in order of first use
+  int nUsed;
+} RowHash;
+
+/** Initialize h for rows with at most maxKeys distinct columns. */
+static void
+row_hash_init(RowHash *h, int maxKeys)
+{
+  int size = MIN_HASH_SIZE, shift = 32 - MIN_HASH_BITS;
+  while (size < 2 * maxKeys) {
+    size *= 2;
+    shift--;
+  }
+  h->size = size;
+  h->shift = shift;
+  h->keys = must_malloc(size * sizeof(int));
+  h->vals = must_malloc(size * sizeof(double));
+  h->used = must_malloc(size * sizeof(int));
+  memset(h->keys, -1, size * sizeof(int));
+  h->nUsed = 0;
+}
+
+static void
+row_hash_free(RowHash *h)
+{
+  free(h->keys); free(h->vals); free(h->used);
+}
+
+//multiplicative hash: the top log2(size) bits of col * 2^32/phi
+static inline int
+row_hash_slot(const RowHash *h, int col)
+{
+  return (uint32_t)((uint32_t)col * 2654435769u) >> h->shift;
+}
+
+static void
+row_hash_add(RowHash *h, int col, double val)
+{
+  int slot = row_hash_slot(h, col);
+  while (h->keys[slot] != col) {
+    if (h->keys[slot] < 0) {
+      h->keys[slot] = col; h->vals[slot] = 0;
+      h->used[h->nUsed++] = slot;
+      break;
+    }
+    slot = (slot + 1) & (h->size - 1);
+  }
+  h->vals[slot] += val;
+}
+
+/** Empty h in time proportional to the # of slots in use. */
+static void
+row_hash_clear(RowHash *h)
+{
+  for (int u = 0; u < h->nUsed; u++) h->keys[h->used[u]] = -1;
+  h->nUsed = 0;
+}
+
+typedef struct {
+  const CsrMatrix *a, *b;
+  CsrMatrix *c;
+  int isNumeric;  //else count nonzeros of rows into c->ptr[i + 1]
+} SpgemmJob;
+
+//# of products contributing to row i of A B
+static int
+row_products(const CsrMatrix *a, const CsrMatrix *b, int i)
+{
+  int n = 0;
+  for (int p = a->ptr[i]; p < a->ptr[i + 1]; p++) {
+    int k = a->idx[p];
+    n += b->ptr[k + 1] - b->ptr[k];
+  }
+  return n;
+}
+
+/** Sort the n (column, value) pairs in idx[] and val[] by column:
+ *  insertion sort, as rows of sparse products are usually short.
+ */
+static void
+sort_row(int n, int idx[], double val[])
+{
+  for (int p = 1; p < n; p++) {
+    int col = idx[p];
+    double v = val[p];
+    int q = p;
+    for (; q > 0 && idx[q - 1] > col; q--) {
+      idx[q] = idx[q - 1]; val[q] = val[q - 1];
+    }
+    idx[q] = col; val[q] = v;
+  }
+}
+
+static int
+compare_ints(const void *p1, const void *p2)
+{
+  int i1 = *(const int *)p1, i2 = *(const int *)p2;
+  return (i1 > i2) - (i1 < i2);
+}
+
+//rows longer than this are sorted by qsort() rather than sort_row()
+enum { MAX_INSERTION_SORT = 32 };
+
+static void
+spgemm_rows(int begin, int end, int thread, void *arg)
+{
+  const SpgemmJob *job = arg;
+  const CsrMatrix *a = job->a, *b = job->b;
+  CsrMatrix *c = job->c;
+  int maxProducts = 0;
+  for (int i = begin; i < end; i++) {
+    int n = row_products(a, b, i);
+    if (n > maxProducts) maxProducts = n;
+  }
+  RowHash h;
+  row_hash_init(&h, (maxProducts < b->nCols) ? maxProducts : b->nCols);
+  for (int i = begin; i < end; i++) {
+    for (int p = a->ptr[i]; p < a->ptr[i + 1]; p++) {
+      const int k = a->idx[p];
+      const double aik = a->val[p];
+      for (int q = b->ptr[k]; q < b->ptr[k + 1]; q++) {
+        row_hash_add(&h, b->idx[q], aik * b->val[q]);
+      }
+    }
+    if (!job->isNumeric) {
+      c->ptr[i + 1] = h.nUsed;
+    }
+    else {
+      int *idx = &c->idx[c->ptr[i]];
+      double *val = &c->val[c->ptr[i]];
+      if (h.nUsed <= MAX_INSERTION_SORT) {
+        for (int u = 0; u < h.nUsed; u++) {
+          idx[u] = h.keys[h.used[u]]; val[u] = h.vals[h.used[u]];
+        }
+        sort_row(h.nUsed, idx, val);
+      }
+      else {
+        //sort the columns, then look up their values
+        for (int u = 0; u < h.nUsed; u++) idx[u] = h.keys[h.used[u]];
+        qsort(idx, h.nUsed, sizeof(int), compare_ints);
+        for (int u = 0; u < h.nUsed; u++) {
+          int slot = row_hash_slot(&h, idx[u]);
+          while (h.keys[slot] != idx[u]) slot = (slot + 1) & (h.size - 1);
+          val[u] = h.vals[slot];
+        }
+      }
+    }
+    row_hash_clear(&h);
+  }
+  row_hash_free(&h);
+}
+
+CsrMatrix *
+csr_spgemm(const CsrMatrix *a, const CsrMatrix *b)
+{
+  const int m = a->nRows;
+  double work = 0;
+  for (int i = 0; i < m; i++) work += row_products(a, b, i);
+  SparseMatrix counted = { m, b->nCols, 0, NULL, NULL, NULL };
+  counted.ptr = must_malloc((m + 1) * sizeof(int));
+  SpgemmJob job = { a, b, &counted, 0 };
+  parallel_for_work(m, work, spgemm_rows, &job);
+  counts_to_ptr(m, counted.ptr);
+
+  CsrMatrix *c = new_sparse(m, b->nCols, 0, counted.ptr[m]);
+  free(c->ptr);
+  c->ptr = counted.ptr;
+  job.c = c; job.isNumeric = 1;
+  parallel_for_work(m, work, spgemm_rows, &job);
+  return c;
+}
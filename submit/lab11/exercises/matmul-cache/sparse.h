@@ -0,0 +1,68 @@
+#ifndef _SPARSE_H
+#define _SPARSE_H
+
+/** Sparse matrices in compressed sparse row (CSR) and column (CSC)
+ *  format.  Dense matrices are stored by rows with a row stride (ld),
+ *  as for gemm().
+ */
+
+/** A CSR matrix stores the nonzeros of row i at positions [ptr[i],
+ *  ptr[i + 1]) of idx (their column indices, in increasing order) and
+ *  val (their values).  A CSC matrix is the same with the roles of rows
+ *  and columns exchanged: ptr is indexed by column and idx holds row
+ *  indices.
+ */
+typedef struct {
+  int nRows, nCols;
+  int nnz;      //# of nonzeros
+  int *ptr;
+  int *idx;
+  double *val;
+} SparseMatrix;
+
+typedef SparseMatrix CsrMatrix;
+typedef SparseMatrix CscMatrix;
+
+/** Free a, which was returned by a function in this module. */
+void sparse_free(SparseMatrix *a);
+
+/** Return the nonzeros of the nRows x nCols dense matrix a in CSR
+ *  format.
+ */
+CsrMatrix *csr_from_dense(int nRows, int nCols, const double *a, int lda);
+
+/** Return the nonzeros of the nRows x nCols dense matrix a in CSC
+ *  format.
+ */
+CscMatrix *csc_from_dense(int nRows, int nCols, const double *a, int lda);
+
+/** Convert between CSR and CSC: each is the other for the transpose,
+ *  so both are a transposition of the compressed arrays.
+ */
+CscMatrix *csr_to_csc(const CsrMatrix *a);
+CsrMatrix *csc_to_csr(const CscMatrix *a);
+
+/** Store a into the dense a->nRows x a->nCols matrix d, zeros
+ *  included.
+ */
+void csr_to_dense(const CsrMatrix *a, double *d, int ldd);
+
+/** Set y = A x. */
+void csr_spmv(const CsrMatrix *a, const double *x, double *y);
+void csc_spmv(const CscMatrix *a, const double *x, double *y);
+
+/** Set the dense a->nRows x n matrix C = A B for the dense a->nCols x n
+ *  matrix B.  Rows of C are computed in parallel in the thread pool
+ *  (see thread-pool.h).
+ */
+void csr_spmm(const CsrMatrix *a, int n, const double *b, int ldb,
+              double *c, int ldc);
+
+/** Return the sparse product A B, whose nonzeros are the entries which
+ *  have at least one contributing product (even if they sum to 0).
+ *  Rows are computed in parallel in the thread pool (see
+ *  thread-pool.h).
+ */
+CsrMatrix *csr_spgemm(const CsrMatrix *a, const CsrMatrix *b);
+
+#endif //#ifndef _SPARSE_H
@@ -0,0 +1,204 @@
+#include "matmul.h"
+#include "packed-gemm.h"
+#include "strassen.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Strassen-Winograd matrix multiply.  An even-sized product is split
+ *  into quadrants and computed with 7 half-size products and 15
+ *  half-size additions (Winograd's variant of Strassen's algorithm);
+ *  the half-size products recurse until the size is at most the
+ *  cutoff, where the packed kernel in packed-gemm.c takes over.
+ *
+ *  An odd size m is handled by dynamic peeling: the leading (m-1) x
+ *  (m-1) product recurses and the last row and column are fixed up
+ *  with O(m^2) loops.
+ *
+ *  The four half-size temporaries needed by each level are carved from
+ *  a single workspace arena used as a stack; it is allocated for the
+ *  largest size seen so far, so repeated calls allocate nothing.
+ */
+
+typedef struct {
+  double *base;
+  size_t size;  //# of doubles in base
+  size_t top;   //# of doubles in use
+} Workspace;
+
+static int CUTOFF = STRASSEN_CUTOFF;
+
+//static so that no memory is allocated per call
+static PackedBuffers BUFFERS;
+static Workspace WORKSPACE;
+
+void
+strassen_set_cutoff(int cutoff)
+{
+  CUTOFF = (cutoff < 1) ? STRASSEN_CUTOFF : cutoff;
+}
+
+//# of doubles reserved for an h x h temporary: whole cache lines
+static size_t
+tmp_size(int h)
+{
+  return ((size_t)h * h + 7) & ~(size_t)7;
+}
+
+/** Return # of doubles of workspace needed to multiply m x m matrices. */
+static size_t
+workspace_size(int m)
+{
+  size_t size = 0;
+  while (m > CUTOFF) {
+    m /= 2;  //peeling an odd m loses 1 before halving
+    size += 4 * tmp_size(m);
+  }
+  return size;
+}
+
+static void
+reserve_workspace(Workspace *ws, size_t size)
+{
+  if (size > ws->size) {
+    free(ws->base);
+    ws->base = aligned_alloc(64, size * sizeof(double));
+    if (!ws->base) {
+      fprintf(stderr, "could not malloc workspace: %s\n", strerror(errno));
+      exit(1);
+    }
+    ws->size = size;
+  }
+  ws->top = 0;
+}
+
+static double *
+push_tmp(Workspace *ws, int h)
+{
+  double *tmp = &ws->base[ws->top];
+  ws->top += tmp_size(h);
+  return tmp;
+}
+
+//z = x + y for h x h matrices; z may be x or y
+static void
+add(int h, double *z, int ldz, const double *x, int ldx,
+    const double *y, int ldy)
+{
+  for (int i = 0; i < h; i++) {
+    double *zi = &z[(long)i*ldz];
+    const double *xi = &x[(long)i*ldx], *yi = &y[(long)i*ldy];
+    for (int j = 0; j < h; j++) zi[j] = xi[j] + yi[j];
+  }
+}
+
+//z = x - y for h x h matrices; z may be x or y
+static void
+sub(int h, double *z, int ldz, const double *x, int ldx,
+    const double *y, int ldy)
+{
+  for (int i = 0; i < h; i++) {
+    double *zi = &z[(long)i*ldz];
+    const double *xi = &x[(long)i*ldx], *yi = &y[(long)i*ldy];
+    for (int j = 0; j < h; j++) zi[j] = xi[j] - yi[j];
+  }
+}
+
+/** Set C = A * B for odd m, given that the leading (m-1) x (m-1) block
+ *  of C already holds the product of the leading blocks of A and B.
+ */
+static void
+fix_peeled(int m, const double *a, int lda, const double *b, int ldb,
+           double *c, int ldc)
+{
+  const int p = m - 1;
+  const double *bp = &b[(long)p*ldb];
+  for (int i = 0; i < p; i++) {
+    //rank-1 update by last column of A and last row of B
+    double *ci = &c[(long)i*ldc];
+    const double *ai = &a[(long)i*lda];
+    const double aip = ai[p];
+    for (int j = 0; j < p; j++) ci[j] += aip*bp[j];
+    //last column of C
+    double sum = 0;
+    for (int k = 0; k < m; k++) sum += ai[k]*b[(long)k*ldb + p];
+    ci[p] = sum;
+  }
+  //last row of C
+  double *cp = &c[(long)p*ldc];
+  const double *ap = &a[(long)p*lda];
+  for (int j = 0; j < m; j++) cp[j] = 0;
+  for (int k = 0; k < m; k++) {
+    const double apk = ap[k];
+    const double *bk = &b[(long)k*ldb];
+    for (int j = 0; j < m; j++) cp[j] += apk*bk[j];
+  }
+}
+
+/** Set C = A * B for m x m matrices with row strides lda, ldb, ldc. */
+static void
+strassen(int m, const double *a, int lda, const double *b, int ldb,
+         double *c, int ldc, Workspace *ws)
+{
+  if (m <= CUTOFF) {
+    packed_gemm(GEMM_NO_TRANS, GEMM_NO_TRANS, m, m, m, 1, a, lda, b, ldb,
+                0, c, ldc, &BUFFERS);
+    return;
+  }
+  if (m % 2 != 0) {
+    strassen(m - 1, a, lda, b, ldb, c, ldc, ws);
+    fix_peeled(m, a, lda, b, ldb, c, ldc);
+    return;
+  }
+  const int h = m / 2;
+  const double *a11 = a, *a12 = a + h;
+  const double *a21 = a + (long)h*lda, *a22 = a21 + h;
+  const double *b11 = b, *b12 = b + h;
+  const double *b21 = b + (long)h*ldb, *b22 = b21 + h;
+  double *c11 = c, *c12 = c + h;
+  double *c21 = c + (long)h*ldc, *c22 = c21 + h;
+
+  //operands x, y and products p, q of the 7 half-size products
+  const size_t top = ws->top;
+  double *x = push_tmp(ws, h), *y = push_tmp(ws, h);
+  double *p = push_tmp(ws, h), *q = push_tmp(ws, h);
+
+  strassen(h, a11, lda, b11, ldb, p, h, ws);        //p = M1 = A11 B11
+  strassen(h, a12, lda, b21, ldb, c11, ldc, ws);    //c11 = M2 = A12 B21
+  add(h, c11, ldc, c11, ldc, p, h);                 //c11 = M1 + M2
+
+  add(h, x, h, a21, lda, a22, lda);                 //x = S1
+  sub(h, y, h, b12, ldb, b11, ldb);                 //y = T1
+  strassen(h, x, h, y, h, c22, ldc, ws);            //c22 = M5 = S1 T1
+
+  sub(h, x, h, x, h, a11, lda);                     //x = S2 = S1 - A11
+  sub(h, y, h, b22, ldb, y, h);                     //y = T2 = B22 - T1
+  strassen(h, x, h, y, h, c12, ldc, ws);            //c12 = M6 = S2 T2
+  add(h, c12, ldc, c12, ldc, p, h);                 //c12 = U2 = M1 + M6
+
+  sub(h, x, h, a12, lda, x, h);                     //x = S4 = A12 - S2
+  strassen(h, x, h, b22, ldb, p, h, ws);            //p = M3 = S4 B22
+  sub(h, y, h, y, h, b21, ldb);                     //y = T4 = T2 - B21
+  strassen(h, a22, lda, y, h, q, h, ws);            //q = M4 = A22 T4
+
+  sub(h, x, h, a11, lda, a21, lda);                 //x = S3
+  sub(h, y, h, b22, ldb, b12, ldb);                 //y = T3
+  strassen(h, x, h, y, h, c21, ldc, ws);            //c21 = M7 = S3 T3
+  add(h, c21, ldc, c21, ldc, c12, ldc);             //c21 = U3 = U2 + M7
+
+  add(h, c12, ldc, c12, ldc, c22, ldc);             //c12 = U4 = U2 + M5
+  add(h, c22, ldc, c22, ldc, c21, ldc);             //c22 = U7 = U3 + M5
+  add(h, c12, ldc, c12, ldc, p, h);                 //c12 = U5 = U4 + M3
+  sub(h, c21, ldc, c21, ldc, q, h);                 //c21 = U6 = U3 - M4
+
+  ws->top = top;
+}
+
+void
+matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
+{
+  reserve_workspace(&WORKSPACE, workspace_size(n));
+  strassen(n, &a[0][0], n, &b[0][0], n, &c[0][0], n, &WORKSPACE);
+}
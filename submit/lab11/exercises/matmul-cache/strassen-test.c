@@ -0,0 +1,65 @@
+#define _XOPEN_SOURCE 1
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "matmul.h"
+#include "matrix-util.h"
+#include "strassen.h"
+
+/** Compare the Strassen-Winograd matrix_multiply() with the classic
+ *  O(n^3) algorithm for sizes and cutoffs which exercise several levels
+ *  of recursion and peeling, reporting the normwise_error() of
+ *  matrix-util.h in units of DBL_EPSILON.  The test fails only if it
+ *  exceeds MAX_ERROR_EPS.
+ */
+
+enum { MAX_ERROR_EPS = 64 };
+
+static const struct {
+  int n, cutoff;
+} CASES[] = {
+  { 1, 0 }, { 6, 0 },
+  { 64, 8 }, { 65, 8 }, { 127, 16 }, { 200, 7 }, { 257, 32 },
+  { 300, 16 }, { 513, 64 }, { 1024, 0 }, { 1031, 0 },
+};
+
+/** Return relative error in units of DBL_EPSILON for an n x n product. */
+static double
+test_size(int n, int cutoff)
+{
+  double (*a)[n] = must_malloc(sizeof(double[n][n]));
+  double (*b)[n] = must_malloc(sizeof(double[n][n]));
+  double (*c)[n] = must_malloc(sizeof(double[n][n]));
+  double (*ref)[n] = must_malloc(sizeof(double[n][n]));
+  random_fill(&a[0][0], (long)n * n, 1);
+  random_fill(&b[0][0], (long)n * n, 1);
+  strassen_set_cutoff(cutoff);
+  matrix_multiply(n, a, b, c);
+  classic_multiply(n, n, n, &a[0][0], &b[0][0], &ref[0][0]);
+  double err = normwise_error(n, &a[0][0], &b[0][0], &c[0][0], &ref[0][0]);
+  free(a); free(b); free(c); free(ref);
+  return err / DBL_EPSILON;
+}
+
+int
+main(void)
+{
+  int nFail = 0;
+  test_init();
+  printf("%6s %6s %12s\n", "n", "cutoff", "error/eps");
+  for (int t = 0; t < sizeof(CASES)/sizeof(CASES[0]); t++) {
+    int n = CASES[t].n, cutoff = CASES[t].cutoff;
+    double err = test_size(n, cutoff);
+    int isFail = !(err <= MAX_ERROR_EPS);
+    printf("%6d %6d %12.3f%s\n", n, cutoff > 0 ? cutoff : STRASSEN_CUTOFF,
+           err, isFail ? "  FAIL" : "");
+    nFail += isFail;
+  }
+  if (nFail > 0) {
+    fprintf(stderr, "%d of %zu cases exceed %d eps\n", nFail,
+            sizeof(CASES)/sizeof(CASES[0]), MAX_ERROR_EPS);
+  }
+  return nFail > 0;
+}
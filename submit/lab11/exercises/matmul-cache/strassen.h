@@ -0,0 +1,18 @@
+#ifndef _STRASSEN_H
+#define _STRASSEN_H
+
+/** Strassen-Winograd matrix multiply: matrix_multiply() in
+ *  strassen-matmul.c.
+ */
+
+/** Default size at or below which the recursion stops and the packed
+ *  kernel is used, tuned on an AVX2/FMA machine.
+ */
+enum { STRASSEN_CUTOFF = 512 };
+
+/** Set the cutoff used by subsequent calls; values < 1 restore
+ *  STRASSEN_CUTOFF.  Meant for tests and tuning.
+ */
+void strassen_set_cutoff(int cutoff);
+
+#endif //#ifndef _STRASSEN_H
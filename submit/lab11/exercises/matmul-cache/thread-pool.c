@@ -0,0 +1,160 @@
+#define _GNU_SOURCE  //for sysconf(_SC_NPROCESSORS_ONLN)
+
+#include "thread-pool.h"
+#include "tuning.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+enum { MAX_THREADS = 256 };
+
+//the caller of parallel_for() is thread 0; workers are threads
+//[1, nThreads).  Each call publishes its job and bumps generation;
+//workers run their chunk of every generation they have not yet seen.
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t workReady;
+  pthread_cond_t workDone;
+  pthread_cond_t barrierDone;
+  int nThreads;               //0 until determined
+  int isFixed;                //nThreads has been returned: now fixed
+  int isStarted;              //workers have been started
+  unsigned long generation;   //# of jobs posted
+  int nPending;               //# of workers still running current job
+  int n;                      //current job
+  RangeFn *fn;
+  void *arg;
+  unsigned long nBarriers;    //# of pool_barrier()s passed
+  int nAtBarrier;             //# of threads waiting at the current one
+} POOL = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .workReady = PTHREAD_COND_INITIALIZER,
+  .workDone = PTHREAD_COND_INITIALIZER,
+  .barrierDone = PTHREAD_COND_INITIALIZER,
+};
+
+void
+set_n_threads(int nThreads)
+{
+  if (!POOL.isFixed && nThreads > 0) {
+    POOL.nThreads = (nThreads < MAX_THREADS) ? nThreads : MAX_THREADS;
+  }
+}
+
+int
+get_n_threads(void)
+{
+  if (POOL.nThreads == 0) {
+    const char *env = getenv("MATMUL_THREADS");
+    long n = env ? atol(env) : get_tuning()->nThreads;
+    if (!env && n < 1) n = sysconf(_SC_NPROCESSORS_ONLN);
+    POOL.nThreads = (n < 1) ? 1 : (n < MAX_THREADS) ? n : MAX_THREADS;
+  }
+  //callers size per-thread state by it
+  POOL.isFixed = 1;
+  return POOL.nThreads;
+}
+
+static void
+run_chunk(int thread, int nThreads, int n, RangeFn *fn, void *arg)
+{
+  int begin = (long long)n * thread / nThreads;
+  int end = (long long)n * (thread + 1) / nThreads;
+  if (begin < end) fn(begin, end, thread, arg);
+}
+
+static void *
+worker(void *arg)
+{
+  const int thread = (intptr_t)arg;
+  unsigned long seen = 0;
+  pthread_mutex_lock(&POOL.lock);
+  for (;;) {
+    while (POOL.generation == seen) {
+      pthread_cond_wait(&POOL.workReady, &POOL.lock);
+    }
+    seen = POOL.generation;
+    int n = POOL.n;
+    RangeFn *fn = POOL.fn;
+    void *fnArg = POOL.arg;
+    pthread_mutex_unlock(&POOL.lock);
+
+    run_chunk(thread, POOL.nThreads, n, fn, fnArg);
+
+    pthread_mutex_lock(&POOL.lock);
+    if (--POOL.nPending == 0) pthread_cond_signal(&POOL.workDone);
+  }
+  return NULL;
+}
+
+static void
+start_workers(void)
+{
+  for (int t = 1; t < POOL.nThreads; t++) {
+    pthread_t tid;
+    int err = pthread_create(&tid, NULL, worker, (void *)(intptr_t)t);
+    if (err != 0) {
+      fprintf(stderr, "cannot create thread: %s\n", strerror(err));
+      exit(1);
+    }
+    pthread_detach(tid);
+  }
+  POOL.isStarted = 1;
+}
+
+void
+parallel_for(int n, RangeFn *fn, void *arg)
+{
+  int nThreads = get_n_threads();
+  if (nThreads == 1) {
+    run_chunk(0, 1, n, fn, arg);
+    return;
+  }
+  pthread_mutex_lock(&POOL.lock);
+  if (!POOL.isStarted) start_workers();
+  POOL.n = n; POOL.fn = fn; POOL.arg = arg;
+  POOL.nPending = nThreads - 1;
+  POOL.generation++;
+  pthread_cond_broadcast(&POOL.workReady);
+  pthread_mutex_unlock(&POOL.lock);
+
+  run_chunk(0, nThreads, n, fn, arg);
+
+  pthread_mutex_lock(&POOL.lock);
+  while (POOL.nPending > 0) pthread_cond_wait(&POOL.workDone, &POOL.lock);
+  pthread_mutex_unlock(&POOL.lock);
+}
+
+void
+parallel_for_work(int n, double work, RangeFn *fn, void *arg)
+{
+  if (work < PARALLEL_MIN_WORK) {
+    fn(0, n, 0, arg);
+  }
+  else {
+    parallel_for(n, fn, arg);
+  }
+}
+
+void
+pool_barrier(void)
+{
+  if (POOL.nThreads <= 1) return;
+  pthread_mutex_lock(&POOL.lock);
+  unsigned long barrier = POOL.nBarriers;
+  if (++POOL.nAtBarrier == POOL.nThreads) {
+    POOL.nAtBarrier = 0;
+    POOL.nBarriers++;
+    pthread_cond_broadcast(&POOL.barrierDone);
+  }
+  else {
+    while (POOL.nBarriers == barrier) {
+      pthread_cond_wait(&POOL.barrierDone, &POOL.lock);
+    }
+  }
+  pthread_mutex_unlock(&POOL.lock);
+}
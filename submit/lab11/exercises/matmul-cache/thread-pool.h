@@ -0,0 +1,54 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+/** A process-wide pool of worker threads for data-parallel loops.
+ *  Workers are started by the first parallel_for() and then wait for
+ *  further work, so that repeated calls do not pay for thread creation.
+ *
+ *  The pool runs one loop at a time, so a function documented as
+ *  running in the pool must not be called concurrently with another
+ *  one, nor from the fn of a parallel_for().
+ */
+
+/** Called with a thread index in [0, get_n_threads()) and that
+ *  thread's share [begin, end) of a parallel_for() range.
+ */
+typedef void RangeFn(int begin, int end, int thread, void *arg);
+
+/** Set the # of threads used by parallel_for(), overriding the
+ *  MATMUL_THREADS environment variable or, if that is not set, the #
+ *  found by matmul-tune (see tuning.h) or else the # of online CPUs.
+ *  Only effective before the first get_n_threads() or parallel_for(),
+ *  after which the # is fixed, since callers may have sized per-thread
+ *  state by it.
+ */
+void set_n_threads(int nThreads);
+
+/** Return the # of threads used by parallel_for(). */
+int get_n_threads(void);
+
+/** Split [0, n) into get_n_threads() contiguous chunks of nearly equal
+ *  size and call fn on every chunk concurrently; chunk t is always run
+ *  by the same thread t (the caller is thread 0), so that the same n
+ *  always maps the same range to the same thread.  Returns when all
+ *  chunks are done.  Must not be called concurrently or from fn.
+ */
+void parallel_for(int n, RangeFn *fn, void *arg);
+
+//loops with less work than this are not worth waking the pool for
+enum { PARALLEL_MIN_WORK = 64 * 64 * 64 };
+
+/** parallel_for(), unless work, an estimate of the # of basic
+ *  operations (e.g. multiply-adds) of the whole loop, is less than
+ *  PARALLEL_MIN_WORK: then the caller alone calls fn(0, n, 0, arg).
+ */
+void parallel_for_work(int n, double work, RangeFn *fn, void *arg);
+
+/** Wait until all get_n_threads() threads have called pool_barrier().
+ *  Only for the fn of a parallel_for() whose n is at least the # of
+ *  threads, so that every thread runs a chunk and so reaches the
+ *  barrier.  Does nothing with 1 thread.
+ */
+void pool_barrier(void);
+
+#endif //#ifndef _THREAD_POOL_H
@@ -0,0 +1,94 @@
+#define _GNU_SOURCE  //for sysconf(_SC_LEVEL1_DCACHE_SIZE), etc.
+
+#include "matmul.h"
+
+#include <unistd.h>
+
+/** Cache-blocked matrix multiply.  B is split into blocks of
+ *  kTile rows by jTile columns; each block is small enough to stay in
+ *  the L2 cache while it is used to update every row of C, and a row of
+ *  the block together with the corresponding jTile segment of a row of
+ *  C fits comfortably in the L1 cache.  The innermost loop runs along
+ *  rows of B and C, so all accesses have unit stride.  Tile sizes are
+ *  computed once from the cache sizes of the running machine; no
+ *  memory is allocated.
+ */
+
+//used when the cache sizes cannot be determined
+enum {
+  DEFAULT_L1_SIZE = 32 * 1024,
+  DEFAULT_L2_SIZE = 256 * 1024,
+};
+
+//# of rows of B combined in one pass over a segment of a row of C
+enum { K_UNROLL = 4 };
+
+static long
+cache_size(int name, long defaultSize)
+{
+  long size = sysconf(name);
+  return (size > 0) ? size : defaultSize;
+}
+
+/** Set *jTile and *kTile from the cache sizes: 2 rows (of B and C) of
+ *  jTile doubles use at most half of L1 and a kTile x jTile block of B
+ *  at most half of L2.
+ */
+static void
+get_tile_sizes(int *jTile, int *kTile)
+{
+  static int jCached, kCached;
+  if (jCached == 0) {
+    long l1 = cache_size(_SC_LEVEL1_DCACHE_SIZE, DEFAULT_L1_SIZE);
+    long l2 = cache_size(_SC_LEVEL2_CACHE_SIZE, DEFAULT_L2_SIZE);
+    int j = l1 / 2 / (2 * sizeof(double));
+    j -= j % 8;   //whole cache lines
+    int k = l2 / 2 / (j * sizeof(double));
+    k -= k % K_UNROLL;
+    kCached = (k < K_UNROLL) ? K_UNROLL : k;
+    jCached = (j < 8) ? 8 : j;
+  }
+  *jTile = jCached; *kTile = kCached;
+}
+
+/** c[i][j0, j1) += a[i][k0, k1) * b[k0, k1)[j0, j1) for all rows i. */
+static void
+multiply_block(int n, double a[][n], double b[][n], double c[][n],
+               int j0, int j1, int k0, int k1)
+{
+  for (int i = 0; i < n; i++) {
+    double *restrict ci = c[i];
+    int k = k0;
+    for (; k + K_UNROLL <= k1; k += K_UNROLL) {
+      const double a0 = a[i][k], a1 = a[i][k + 1];
+      const double a2 = a[i][k + 2], a3 = a[i][k + 3];
+      const double *restrict b0 = b[k], *restrict b1 = b[k + 1];
+      const double *restrict b2 = b[k + 2], *restrict b3 = b[k + 3];
+      for (int j = j0; j < j1; j++) {
+        ci[j] += a0*b0[j] + a1*b1[j] + a2*b2[j] + a3*b3[j];
+      }
+    }
+    for (; k < k1; k++) {
+      const double aik = a[i][k];
+      const double *restrict bk = b[k];
+      for (int j = j0; j < j1; j++) ci[j] += aik*bk[j];
+    }
+  }
+}
+
+void
+matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
+{
+  int jTile, kTile;
+  get_tile_sizes(&jTile, &kTile);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) c[i][j] = 0;
+  }
+  for (int j0 = 0; j0 < n; j0 += jTile) {
+    int j1 = (j0 + jTile < n) ? j0 + jTile : n;
+    for (int k0 = 0; k0 < n; k0 += kTile) {
+      int k1 = (k0 + kTile < n) ? k0 + kTile : n;
+      multiply_block(n, a, b, c, j0, j1, k0, k1);
+    }
+  }
+}
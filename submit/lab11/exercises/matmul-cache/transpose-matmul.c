@@ -5,18 +5,45 @@
 #include <stdlib.h>
 #include <string.h>
 
+//transposes of blocks with at most this many elements are not split
+enum { TRANSPOSE_BASE = 16 * 16 };
+
+/** Set the cols x rows matrix t (row stride ldt) to the transpose of
+ *  the rows x cols matrix a (row stride lda) by halving the larger
+ *  dimension until the block is small.  Reading a by columns strides
+ *  a whole row per element, so a plain double loop misses in the cache
+ *  and TLB on every access of one of the matrices once n is large;
+ *  small blocks of both fit in L1 at every level of recursion, without
+ *  a tuned block size.
+ */
+static void
+transpose_block(int rows, int cols, const double *a, int lda, double *t,
+                int ldt)
+{
+  if (rows * cols <= TRANSPOSE_BASE) {
+    for (int i = 0; i < rows; i++) {
+      for (int j = 0; j < cols; j++) t[(long)j*ldt + i] = a[(long)i*lda + j];
+    }
+  }
+  else if (rows >= cols) {
+    int h = rows / 2;
+    transpose_block(h, cols, a, lda, t, ldt);
+    transpose_block(rows - h, cols, &a[(long)h*lda], lda, &t[h], ldt);
+  }
+  else {
+    int h = cols / 2;
+    transpose_block(rows, h, a, lda, t, ldt);
+    transpose_block(rows, cols - h, &a[h], lda, &t[(long)h*ldt], ldt);
+  }
+}
+
 /** Fill in matrix t[n][n] as the transpose of matrix a[n][n].  That is,
  *  for all i, j set t[i][j] to a[j][i].
  */
 static void
 matrix_transpose(int n, double a[][n], double t[][n])
 {
-  //@TODO add your code here
-  for(int i = 0; i < n; i++){
-    for(int j = 0; j < n; j++){
-      t[i][j] = a[j][i];
-    }
-  }
+  transpose_block(n, n, &a[0][0], n, &t[0][0], n);
 }
 
 
@@ -38,4 +65,5 @@ matrix_multiply(int n, double a[][n], double b[][n], double c[][n])
       }
     }
   }
+  free(tmp);
 }
@@ -0,0 +1,210 @@
+#define _GNU_SOURCE  //for sysconf(_SC_LEVEL1_DCACHE_SIZE)
+
+#include "tuning.h"
+#include "packed-gemm.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __x86_64__
+  #include <cpuid.h>
+#endif
+
+enum {
+  MAX_LINE = 256,   //longer lines in tuning files are not valid
+  MAX_KEY = 64,     //cpuid brand strings have at most 48 characters
+  MAX_PATH = 4096,
+};
+
+static Tuning TUNING;
+static pthread_once_t TUNING_ONCE = PTHREAD_ONCE_INIT;
+
+/** Remove whitespace from both ends of string s in place, returning
+ *  its new start.
+ */
+static char *
+trim(char *s)
+{
+  while (*s == ' ' || *s == '\t') s++;
+  size_t len = strlen(s);
+  while (len > 0 && strchr(" \t\r\n", s[len - 1])) s[--len] = '\0';
+  return s;
+}
+
+void
+tuning_cpu_key(char key[], size_t size)
+{
+  char brand[MAX_KEY] = "unknown CPU";
+#ifdef __x86_64__
+  unsigned regs[12];
+  if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+    for (unsigned leaf = 0; leaf < 3; leaf++) {
+      __get_cpuid(0x80000002 + leaf, &regs[4*leaf], &regs[4*leaf + 1],
+                  &regs[4*leaf + 2], &regs[4*leaf + 3]);
+    }
+    memcpy(brand, regs, sizeof(regs));
+    brand[sizeof(regs)] = '\0';
+  }
+  else if (__get_cpuid(0, &regs[0], &regs[1], &regs[2], &regs[3])) {
+    //no brand string: vendor (in ebx, edx, ecx) and family/model
+    unsigned vendor[3] = { regs[1], regs[3], regs[2] };
+    unsigned eax = 0, ebx, ecx, edx;
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    unsigned family = (eax >> 8) & 0xf, model = (eax >> 4) & 0xf;
+    if (family == 0xf) family += (eax >> 20) & 0xff;
+    if (family >= 6) model += ((eax >> 16) & 0xf) << 4;
+    snprintf(brand, sizeof(brand), "%.12s family %u model %u",
+             (const char *)vendor, family, model);
+  }
+#endif
+  snprintf(key, size, "%s", trim(brand));
+}
+
+const char *
+tuning_file_path(void)
+{
+  static char path[MAX_PATH];
+  const char *env = getenv("MATMUL_TUNING_FILE");
+  if (env) return (*env == '\0') ? NULL : env;
+  const char *home = getenv("HOME");
+  if (!home) return NULL;
+  snprintf(path, sizeof(path), "%s/.matmul-tuning", home);
+  return path;
+}
+
+/** Return size reduced to at most maxSize and rounded down to a
+ *  multiple of unit, but at least unit.
+ */
+static int
+fit(long size, int unit, int maxSize)
+{
+  if (size > maxSize) size = maxSize;
+  return (size < unit) ? unit : size / unit * unit;
+}
+
+void
+heuristic_tuning(Tuning *tuning)
+{
+  Tuning t = {
+    PACKED_MR, PACKED_NR, PACKED_MC, PACKED_KC, PACKED_NC, 0
+  };
+  long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  //a kc x nr micro-panel of B in half of L1
+  if (l1 > 0) t.kc = fit(l1 / 2 / (t.nr * sizeof(double)), 1, PACKED_MAX_KC);
+  //an mc x kc block of A in half of L2
+  if (l2 > 0) t.mc = fit(l2 / 2 / (t.kc * sizeof(double)), t.mr, PACKED_MAX_MC);
+  //a kc x nc panel of B in half of L3
+  if (l3 > 0) t.nc = fit(l3 / 2 / (t.kc * sizeof(double)), t.nr, PACKED_MAX_NC);
+  *tuning = t;
+}
+
+/** Parse line of a tuning file into *tuning and *key (which points
+ *  into line), returning 1 if it is an entry, 0 if it is a comment or
+ *  blank and -1 if it is not valid.
+ */
+static int
+parse_line(char *line, Tuning *tuning, char **key)
+{
+  char *s = trim(line);
+  if (*s == '\0' || *s == '#') return 0;
+  Tuning t;
+  int len = 0;
+  if (sscanf(s, "%d %d %d %d %d %d %n", &t.mr, &t.nr, &t.mc, &t.kc,
+             &t.nc, &t.nThreads, &len) != 6 || s[len] == '\0') {
+    return -1;
+  }
+  *tuning = t;
+  *key = &s[len];
+  return 1;
+}
+
+/** Set *tuning to the entry for CPU key in the tuning file at path,
+ *  returning 1 if there is one, else 0.
+ */
+static int
+load_tuning(const char *path, const char *key, Tuning *tuning)
+{
+  FILE *in = fopen(path, "r");
+  if (!in) return 0;
+  char line[MAX_LINE];
+  int isFound = 0;
+  for (int lineNum = 1; !isFound && fgets(line, sizeof(line), in);
+       lineNum++) {
+    Tuning t;
+    char *lineKey;
+    int status = parse_line(line, &t, &lineKey);
+    if (status < 0) {
+      fprintf(stderr, "%s:%d: invalid tuning ignored\n", path, lineNum);
+    }
+    else if (status > 0 && strcmp(lineKey, key) == 0) {
+      *tuning = t;
+      isFound = 1;
+    }
+  }
+  fclose(in);
+  return isFound;
+}
+
+static void
+init_tuning(void)
+{
+  char key[MAX_KEY];
+  tuning_cpu_key(key, sizeof(key));
+  const char *path = tuning_file_path();
+  if (!path || !load_tuning(path, key, &TUNING)) heuristic_tuning(&TUNING);
+}
+
+const Tuning *
+get_tuning(void)
+{
+  pthread_once(&TUNING_ONCE, init_tuning);
+  return &TUNING;
+}
+
+void
+set_tuning(const Tuning *tuning)
+{
+  pthread_once(&TUNING_ONCE, init_tuning);  //so it is not loaded later
+  TUNING = *tuning;
+}
+
+int
+save_tuning(const char *path, const char *key, const Tuning *tuning)
+{
+  char tmpPath[MAX_PATH];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+  FILE *out = fopen(tmpPath, "w");
+  if (!out) return -1;
+  FILE *in = fopen(path, "r");
+  if (in) {
+    //copy all but the entry for key
+    char line[MAX_LINE], copy[MAX_LINE];
+    while (fgets(line, sizeof(line), in)) {
+      Tuning t;
+      char *lineKey;
+      strcpy(copy, line);
+      if (parse_line(copy, &t, &lineKey) <= 0 || strcmp(lineKey, key) != 0) {
+        fputs(line, out);
+      }
+    }
+    fclose(in);
+  }
+  else {
+    fprintf(out, "# mr nr mc kc nc threads cpu: written by matmul-tune\n");
+  }
+  fprintf(out, "%d %d %d %d %d %d %s\n", tuning->mr, tuning->nr,
+          tuning->mc, tuning->kc, tuning->nc, tuning->nThreads, key);
+  if (fclose(out) != 0 || rename(tmpPath, path) != 0) {
+    int err = errno;
+    remove(tmpPath);
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef _TUNING_H
+#define _TUNING_H
+
+#include <stddef.h>
+
+/** Machine-dependent parameters of the packed matrix multiply, as found
+ *  by matmul-tune for this CPU or else estimated from its cache sizes.
+ *
+ *  matmul-tune stores its results in a tuning file with a line per CPU
+ *  model, so that one file can be shared by several machines:
+ *
+ *    # mr nr mc kc nc threads cpu
+ *    6 8 72 256 2048 4 Intel(R) Xeon(R) Gold 6148 CPU @ 2.40GHz
+ *
+ *  The CPU is the brand string reported by cpuid, which (unlike its
+ *  family and model numbers) tells apart SKUs with different caches
+ *  and core counts.  The file is $MATMUL_TUNING_FILE, if that is set
+ *  (to the empty string for none), else ~/.matmul-tuning.
+ */
+
+typedef struct {
+  int mr, nr;       //micro-kernel shape
+  int mc, kc, nc;   //packed block sizes: see packed-gemm.c
+  int nThreads;     //# of threads for the thread pool; 0 for default
+} Tuning;
+
+/** Return the tuning for this process: that of this CPU in the tuning
+ *  file, loaded by the first call, or the heuristic one if there is
+ *  none.  The values are not validated; packed-gemm.c rounds them to
+ *  those which it supports.
+ */
+const Tuning *get_tuning(void);
+
+/** Replace the tuning returned by get_tuning().  Must not be called
+ *  while any matrix multiply is running.
+ */
+void set_tuning(const Tuning *tuning);
+
+/** Set *tuning to the heuristic for this CPU: the default kernel, with
+ *  blocks sized to use half of each cache level.
+ */
+void heuristic_tuning(Tuning *tuning);
+
+/** Set key[size] to the name of this CPU in tuning files. */
+void tuning_cpu_key(char key[], size_t size);
+
+/** Return the path of the tuning file, or NULL if there is none. */
+const char *tuning_file_path(void);
+
+/** Store tuning for the CPU named key in the tuning file at path,
+ *  replacing any previous entry for key and keeping those of other
+ *  CPUs.  Returns 0 on success, else -1 with errno set.
+ */
+int save_tuning(const char *path, const char *key, const Tuning *tuning);
+
+#endif //#ifndef _TUNING_H
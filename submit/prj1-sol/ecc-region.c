@@ -0,0 +1,282 @@
+#define _GNU_SOURCE 1  //for MAP_ANONYMOUS and SCHED_IDLE
+
+#include "ecc-region.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+enum {
+  MIN_PARITY_BITS = 4,  //smallest code which holds a whole byte per word
+  MAX_PARITY_BITS = 6,  //largest code which fits in a HammingWord
+  SCRUB_CHUNK_WORDS = 64, //# of words scrubbed while holding the lock
+};
+
+struct EccRegion {
+  HammingWord *words;        //mmap()'d encoded words
+  size_t nWords;
+  size_t mapSize;            //# of bytes mmap()'d
+  size_t nBytes;             //# of user data bytes
+  unsigned nParityBits;
+  unsigned bytesPerWord;     //# of user data bytes in each encoded word
+  pthread_mutex_t lock;      //protects words[] and the counters
+  unsigned long long nCorrected;
+  unsigned long long nSweeps;
+
+  //scrubber state; scrubLock/scrubCond protect isScrubbing
+  pthread_t scrubber;
+  pthread_mutex_t scrubLock;
+  pthread_cond_t scrubCond;
+  bool isScrubbing;
+  size_t bytesPerSecond;
+};
+
+/** Return bytes[n] packed into a data word, bytes[0] in the LSB. */
+static inline HammingWord
+pack_bytes(const unsigned char bytes[], unsigned n)
+{
+  HammingWord data = 0;
+  for (unsigned i = 0; i < n; i++) data |= (HammingWord)bytes[i] << (8*i);
+  return data;
+}
+
+/** Unpack n bytes from data into bytes[]. */
+static inline void
+unpack_bytes(HammingWord data, unsigned char bytes[], unsigned n)
+{
+  for (unsigned i = 0; i < n; i++) bytes[i] = (data >> (8*i)) & 0xff;
+}
+
+/** Decode words[w] of region, repairing it in place if it contains a
+ *  single-bit error.  Sets *isCorrected non-zero on repair.  Must be
+ *  called with region->lock held.
+ */
+static HammingWord
+decode_word(EccRegion *region, size_t w, int *isCorrected)
+{
+  int hasError = 0;
+  HammingWord data =
+    hamming_decode(region->words[w], region->nParityBits, &hasError);
+  if (hasError) {
+    region->words[w] = hamming_encode(data, region->nParityBits);
+    region->nCorrected++;
+  }
+  *isCorrected = hasError;
+  return data;
+}
+
+EccRegion *
+ecc_region_new(size_t nBytes, unsigned nParityBits)
+{
+  if (nParityBits < MIN_PARITY_BITS || nParityBits > MAX_PARITY_BITS) {
+    errno = EINVAL;
+    return NULL;
+  }
+  EccRegion *region = calloc(1, sizeof(EccRegion));
+  if (!region) return NULL;
+  unsigned nDataBits = (1u << nParityBits) - 1 - nParityBits;
+  region->nParityBits = nParityBits;
+  region->bytesPerWord = nDataBits / 8;
+  region->nBytes = nBytes;
+  region->nWords = (nBytes + region->bytesPerWord - 1)/region->bytesPerWord;
+  region->mapSize = (region->nWords > 0 ? region->nWords : 1) *
+    sizeof(HammingWord);
+  region->words = mmap(NULL, region->mapSize, PROT_READ|PROT_WRITE,
+                       MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (region->words == MAP_FAILED) {
+    free(region);
+    return NULL;
+  }
+  //encoding of 0 is 0, so the zero-filled mapping is already valid
+  assert(hamming_encode(0, nParityBits) == 0);
+  pthread_mutex_init(&region->lock, NULL);
+  pthread_mutex_init(&region->scrubLock, NULL);
+  pthread_cond_init(&region->scrubCond, NULL);
+  return region;
+}
+
+void
+ecc_region_free(EccRegion *region)
+{
+  if (!region) return;
+  ecc_region_stop_scrubber(region);
+  munmap(region->words, region->mapSize);
+  pthread_cond_destroy(&region->scrubCond);
+  pthread_mutex_destroy(&region->scrubLock);
+  pthread_mutex_destroy(&region->lock);
+  free(region);
+}
+
+size_t
+ecc_region_size(const EccRegion *region)
+{
+  return region->nBytes;
+}
+
+size_t
+ecc_region_n_words(const EccRegion *region)
+{
+  return region->nWords;
+}
+
+int
+ecc_region_read(EccRegion *region, size_t offset, void *buf, size_t n)
+{
+  if (offset > region->nBytes || n > region->nBytes - offset) return -1;
+  unsigned char *out = buf;
+  const unsigned bpw = region->bytesPerWord;
+  int nCorrected = 0;
+  pthread_mutex_lock(&region->lock);
+  while (n > 0) {
+    size_t w = offset / bpw;
+    unsigned lo = offset % bpw;
+    unsigned nCopy = (n < bpw - lo) ? n : bpw - lo;
+    int isCorrected;
+    unsigned char bytes[sizeof(HammingWord)];
+    unpack_bytes(decode_word(region, w, &isCorrected), bytes, bpw);
+    nCorrected += isCorrected;
+    memcpy(out, bytes + lo, nCopy);
+    out += nCopy; offset += nCopy; n -= nCopy;
+  }
+  pthread_mutex_unlock(&region->lock);
+  return nCorrected;
+}
+
+int
+ecc_region_write(EccRegion *region, size_t offset, const void *buf, size_t n)
+{
+  if (offset > region->nBytes || n > region->nBytes - offset) return -1;
+  const unsigned char *in = buf;
+  const unsigned bpw = region->bytesPerWord;
+  pthread_mutex_lock(&region->lock);
+  while (n > 0) {
+    size_t w = offset / bpw;
+    unsigned lo = offset % bpw;
+    unsigned nCopy = (n < bpw - lo) ? n : bpw - lo;
+    unsigned char bytes[sizeof(HammingWord)];
+    if (nCopy < bpw) {  //partial word: merge with current contents
+      int isCorrected;
+      unpack_bytes(decode_word(region, w, &isCorrected), bytes, bpw);
+    }
+    memcpy(bytes + lo, in, nCopy);
+    region->words[w] =
+      hamming_encode(pack_bytes(bytes, bpw), region->nParityBits);
+    in += nCopy; offset += nCopy; n -= nCopy;
+  }
+  pthread_mutex_unlock(&region->lock);
+  return 0;
+}
+
+void
+ecc_region_flip_bit(EccRegion *region, size_t wordIndex, unsigned bitIndex)
+{
+  assert(wordIndex < region->nWords);
+  assert(bitIndex > 0 && bitIndex < (1u << region->nParityBits));
+  pthread_mutex_lock(&region->lock);
+  region->words[wordIndex] ^= 1ULL << (bitIndex - 1);
+  pthread_mutex_unlock(&region->lock);
+}
+
+unsigned long long
+ecc_region_n_corrected(EccRegion *region)
+{
+  pthread_mutex_lock(&region->lock);
+  unsigned long long n = region->nCorrected;
+  pthread_mutex_unlock(&region->lock);
+  return n;
+}
+
+unsigned long long
+ecc_region_n_sweeps(EccRegion *region)
+{
+  pthread_mutex_lock(&region->lock);
+  unsigned long long n = region->nSweeps;
+  pthread_mutex_unlock(&region->lock);
+  return n;
+}
+
+/** Add ns nanoseconds to *t. */
+static void
+add_ns(struct timespec *t, long long ns)
+{
+  enum { NS_PER_S = 1000000000 };
+  ns += t->tv_nsec;
+  t->tv_sec += ns / NS_PER_S;
+  t->tv_nsec = ns % NS_PER_S;
+}
+
+/** Scrubber thread: scrub SCRUB_CHUNK_WORDS words at a time, pacing
+ *  chunks so as not to exceed region->bytesPerSecond.
+ */
+static void *
+scrub(void *arg)
+{
+  EccRegion *region = arg;
+#ifdef SCHED_IDLE
+  struct sched_param param = { .sched_priority = 0 };
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+  const long long chunkNs = (long long)SCRUB_CHUNK_WORDS *
+    region->bytesPerWord * 1000000000LL / region->bytesPerSecond;
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  size_t w = 0;
+  pthread_mutex_lock(&region->scrubLock);
+  while (region->isScrubbing) {
+    pthread_mutex_unlock(&region->scrubLock);
+    pthread_mutex_lock(&region->lock);
+    size_t end = w + SCRUB_CHUNK_WORDS;
+    if (end > region->nWords) end = region->nWords;
+    for (; w < end; w++) {
+      int isCorrected;
+      decode_word(region, w, &isCorrected);
+    }
+    if (w == region->nWords) {
+      region->nSweeps++;
+      w = 0;
+    }
+    pthread_mutex_unlock(&region->lock);
+    add_ns(&deadline, chunkNs);
+    pthread_mutex_lock(&region->scrubLock);
+    while (region->isScrubbing &&
+           pthread_cond_timedwait(&region->scrubCond, &region->scrubLock,
+                                  &deadline) != ETIMEDOUT) {
+    }
+  }
+  pthread_mutex_unlock(&region->scrubLock);
+  return NULL;
+}
+
+int
+ecc_region_start_scrubber(EccRegion *region, size_t bytesPerSecond)
+{
+  if (bytesPerSecond == 0) return EINVAL;
+  pthread_mutex_lock(&region->scrubLock);
+  if (region->isScrubbing) {
+    pthread_mutex_unlock(&region->scrubLock);
+    return EBUSY;
+  }
+  region->bytesPerSecond = bytesPerSecond;
+  region->isScrubbing = true;
+  int err = pthread_create(&region->scrubber, NULL, scrub, region);
+  if (err) region->isScrubbing = false;
+  pthread_mutex_unlock(&region->scrubLock);
+  return err;
+}
+
+void
+ecc_region_stop_scrubber(EccRegion *region)
+{
+  pthread_mutex_lock(&region->scrubLock);
+  bool wasScrubbing = region->isScrubbing;
+  region->isScrubbing = false;
+  pthread_cond_signal(&region->scrubCond);
+  pthread_mutex_unlock(&region->scrubLock);
+  if (wasScrubbing) pthread_join(region->scrubber, NULL);
+}
@@ -0,0 +1,75 @@
+#ifndef ECC_REGION_H_
+#define ECC_REGION_H_
+
+#include "hamming.h"
+
+#include <stddef.h>
+
+/** An EccRegion stores nBytes of user data as Hamming-encoded words
+ *  in an mmap()'d region.  Reads decode the covering words and repair
+ *  any single-bit error in place; an optional background scrubber
+ *  sweeps the region incrementally so that latent single-bit errors
+ *  are repaired before a second error can accumulate in the same word.
+ *
+ *  All functions are safe to call concurrently with the scrubber.
+ */
+typedef struct EccRegion EccRegion;
+
+/** Return a newly allocated region able to hold nBytes of data
+ *  (initially all zero) protected using nParityBits Hamming parity
+ *  bits per word.  nParityBits must be in [4, 6] so that each encoded
+ *  word can hold at least one data byte.  Returns NULL with errno set
+ *  on error.
+ */
+EccRegion *ecc_region_new(size_t nBytes, unsigned nParityBits);
+
+/** Stop the scrubber (if running) and release all resources used by
+ *  region.
+ */
+void ecc_region_free(EccRegion *region);
+
+/** Return # of data bytes which can be stored in region. */
+size_t ecc_region_size(const EccRegion *region);
+
+/** Copy n bytes starting at offset in region into buf[].  Any
+ *  single-bit errors in the words read are corrected both in buf[]
+ *  and in region.  Returns the # of words corrected, or -1 if the
+ *  range [offset, offset + n) is not within region.
+ */
+int ecc_region_read(EccRegion *region, size_t offset, void *buf, size_t n);
+
+/** Copy n bytes from buf[] into region starting at offset.  Only the
+ *  words covering [offset, offset + n) are re-encoded.  Returns 0 on
+ *  success, -1 if the range is not within region.
+ */
+int ecc_region_write(EccRegion *region, size_t offset,
+                     const void *buf, size_t n);
+
+/** Flip bit bitIndex (numbered from 1 at the LSB, as in hamming.c) of
+ *  encoded word wordIndex.  Used for fault injection.
+ */
+void ecc_region_flip_bit(EccRegion *region, size_t wordIndex,
+                         unsigned bitIndex);
+
+/** Return # of encoded words used by region. */
+size_t ecc_region_n_words(const EccRegion *region);
+
+/** Start a low-priority background thread which repeatedly sweeps
+ *  region at (approximately) bytesPerSecond data bytes per second,
+ *  repairing single-bit errors.  Returns 0 on success, an errno value
+ *  on failure.
+ */
+int ecc_region_start_scrubber(EccRegion *region, size_t bytesPerSecond);
+
+/** Stop the scrubber started by ecc_region_start_scrubber().  No-op if
+ *  no scrubber is running.
+ */
+void ecc_region_stop_scrubber(EccRegion *region);
+
+/** Return total # of words corrected so far by reads and the scrubber. */
+unsigned long long ecc_region_n_corrected(EccRegion *region);
+
+/** Return # of complete sweeps made by the scrubber so far. */
+unsigned long long ecc_region_n_sweeps(EccRegion *region);
+
+#endif //ifndef ECC_REGION_H_
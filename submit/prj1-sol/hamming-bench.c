@@ -0,0 +1,214 @@
+#define _POSIX_C_SOURCE 200809L  //for clock_gettime()
+
+#include "hamming.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Throughput benchmark and fault-injection harness for the Hamming
+ *  codec.  For each # of parity bits in [MIN_PARITY_BITS,
+ *  MAX_PARITY_BITS] and each batch size, times encoding and decoding
+ *  of N_WORDS random data words using the scalar (word-at-a-time)
+ *  and batch codecs.  Before decoding, a random single-bit error is
+ *  injected into each encoded word with probability ERROR_RATE; every
+ *  decoded word is checked against the original data and every
+ *  injected error must be reported as corrected.  Exits with status
+ *  1 on any mismatch.
+ */
+
+enum {
+  MIN_PARITY_BITS = 2,
+  MAX_PARITY_BITS = 6,
+  DEFAULT_N_WORDS = 1 << 20,
+};
+
+static const size_t BATCH_SIZES[] = { 1, 16, 256, 4096 };
+#define N_BATCH_SIZES (sizeof(BATCH_SIZES)/sizeof(BATCH_SIZES[0]))
+
+/** xorshift64* PRNG: deterministic across platforms given a seed. */
+static unsigned long long
+next_rand(unsigned long long *state)
+{
+  unsigned long long x = *state;
+  x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double
+now_secs(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1e9;
+}
+
+static void
+report(const char *op, const char *path, unsigned nParityBits,
+       size_t batchSize, size_t nWords, unsigned nDataBits, double secs)
+{
+  double wordsPerSec = nWords/secs;
+  printf("%-6s %-6s p=%u batch=%-5zu %12.0f words/s %10.2f MB/s\n",
+         op, path, nParityBits, batchSize, wordsPerSec,
+         wordsPerSec*nDataBits/8/1e6);
+}
+
+/** Check decoded[n] against data[n] and errors[n] against injected[n];
+ *  on mismatch print a diagnostic and return false.
+ */
+static bool
+check_decoded(const char *path, unsigned nParityBits,
+              const HammingWord data[], const HammingWord decoded[],
+              const unsigned char injected[], const unsigned char errors[],
+              size_t n)
+{
+  for (size_t i = 0; i < n; i++) {
+    if (decoded[i] != data[i] || !errors[i] != !injected[i]) {
+      fprintf(stderr, "%s p=%u word %zu: data %llu decoded %llu, "
+              "injected %d corrected %d\n", path, nParityBits, i,
+              data[i], decoded[i], injected[i], errors[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/** Run benchmark for nParityBits over nWords words.  Return false on
+ *  any codec mismatch.
+ */
+static bool
+bench(unsigned nParityBits, size_t nWords, double errorRate,
+      unsigned long long *seed)
+{
+  const unsigned nEncodedBits = (1u << nParityBits) - 1;
+  const unsigned nDataBits = nEncodedBits - nParityBits;
+  const HammingWord dataMask = (1ULL << nDataBits) - 1;
+  HammingWord *data = malloc(nWords*sizeof(HammingWord));
+  HammingWord *encoded = malloc(nWords*sizeof(HammingWord));
+  HammingWord *batchEncoded = malloc(nWords*sizeof(HammingWord));
+  HammingWord *decoded = malloc(nWords*sizeof(HammingWord));
+  unsigned char *injected = malloc(nWords);
+  unsigned char *errors = malloc(nWords);
+  if (!data || !encoded || !batchEncoded || !decoded || !injected ||
+      !errors) {
+    fprintf(stderr, "cannot allocate %zu words\n", nWords);
+    exit(1);
+  }
+  for (size_t i = 0; i < nWords; i++) data[i] = next_rand(seed) & dataMask;
+
+  bool isOk = true;
+  double t0 = now_secs();
+  for (size_t i = 0; i < nWords; i++) {
+    encoded[i] = hamming_encode(data[i], nParityBits);
+  }
+  report("encode", "scalar", nParityBits, 1, nWords, nDataBits,
+         now_secs() - t0);
+  for (size_t b = 0; b < N_BATCH_SIZES; b++) {
+    size_t batchSize = BATCH_SIZES[b];
+    t0 = now_secs();
+    for (size_t i = 0; i < nWords; i += batchSize) {
+      size_t n = (nWords - i < batchSize) ? nWords - i : batchSize;
+      hamming_encode_batch(&data[i], &batchEncoded[i], n, nParityBits);
+    }
+    report("encode", "batch", nParityBits, batchSize, nWords, nDataBits,
+           now_secs() - t0);
+    if (memcmp(encoded, batchEncoded, nWords*sizeof(HammingWord)) != 0) {
+      fprintf(stderr, "batch p=%u: encoding differs from scalar\n",
+              nParityBits);
+      isOk = false;
+    }
+  }
+
+  //inject faults
+  size_t nInjected = 0;
+  //errorRate * 2^64 only fits in the threshold when errorRate < 1
+  const bool isAll = errorRate >= 1.0;
+  const unsigned long long threshold = isAll ? 0 : errorRate * 0x1p64;
+  for (size_t i = 0; i < nWords; i++) {
+    injected[i] = isAll || next_rand(seed) < threshold;
+    if (injected[i]) {
+      encoded[i] ^= 1ULL << (next_rand(seed) % nEncodedBits);
+      nInjected++;
+    }
+  }
+
+  t0 = now_secs();
+  for (size_t i = 0; i < nWords; i++) {
+    int hasError = 0;
+    decoded[i] = hamming_decode(encoded[i], nParityBits, &hasError);
+    errors[i] = hasError;
+  }
+  report("decode", "scalar", nParityBits, 1, nWords, nDataBits,
+         now_secs() - t0);
+  isOk = isOk && check_decoded("scalar", nParityBits, data, decoded,
+                               injected, errors, nWords);
+  for (size_t b = 0; b < N_BATCH_SIZES; b++) {
+    size_t batchSize = BATCH_SIZES[b];
+    size_t nCorrected = 0;
+    t0 = now_secs();
+    for (size_t i = 0; i < nWords; i += batchSize) {
+      size_t n = (nWords - i < batchSize) ? nWords - i : batchSize;
+      nCorrected += hamming_decode_batch(&encoded[i], &decoded[i], n,
+                                         nParityBits, &errors[i]);
+    }
+    report("decode", "batch", nParityBits, batchSize, nWords, nDataBits,
+           now_secs() - t0);
+    isOk = isOk && check_decoded("batch", nParityBits, data, decoded,
+                                 injected, errors, nWords);
+    if (nCorrected != nInjected) {
+      fprintf(stderr, "batch p=%u: corrected %zu of %zu injected errors\n",
+              nParityBits, nCorrected, nInjected);
+      isOk = false;
+    }
+  }
+  printf("faults p=%u: injected %zu, all corrected: %s\n",
+         nParityBits, nInjected, isOk ? "yes" : "NO");
+
+  free(data); free(encoded); free(batchEncoded); free(decoded);
+  free(injected); free(errors);
+  return isOk;
+}
+
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-n N_WORDS] [-e ERROR_RATE] [-s SEED]\n",
+          prog);
+  exit(1);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  size_t nWords = DEFAULT_N_WORDS;
+  double errorRate = 0.01;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage(argv[0]);
+    char *end;
+    if (strcmp(argv[i], "-n") == 0) {
+      long long n = strtoll(argv[++i], &end, 10);
+      if (*end != '\0' || n <= 0) usage(argv[0]);
+      nWords = n;
+    }
+    else if (strcmp(argv[i], "-e") == 0) {
+      errorRate = strtod(argv[++i], &end);
+      if (*end != '\0' || errorRate < 0 || errorRate > 1) usage(argv[0]);
+    }
+    else if (strcmp(argv[i], "-s") == 0) {
+      seed = strtoull(argv[++i], &end, 0);
+      if (*end != '\0' || seed == 0) usage(argv[0]);
+    }
+    else {
+      usage(argv[0]);
+    }
+  }
+  bool isOk = true;
+  for (unsigned p = MIN_PARITY_BITS; p <= MAX_PARITY_BITS; p++) {
+    isOk = bench(p, nWords, errorRate, &seed) && isOk;
+  }
+  return !isOk;
+}
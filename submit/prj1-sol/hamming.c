@@ -26,7 +26,7 @@ set_bit(HammingWord word, int bitIndex, unsigned bitValue)
   assert(bitIndex > 0);
   assert(bitValue == 0 || bitValue == 1);
   //@TODO
-  return (bitValue) ? word | (1<<(bitIndex-1)) : word & ~(1<<(bitIndex-1));
+  return (bitValue) ? word | (1ULL<<(bitIndex-1)) : word & ~(1ULL<<(bitIndex-1));
 }
 
 /** Given a Hamming code with nParityBits, return 2**nParityBits - 1,
@@ -37,7 +37,7 @@ static inline unsigned
 get_n_encoded_bits(unsigned nParityBits)
 {
   //@TODO
-  return (2 << nParityBits)-1;
+  return (1 << nParityBits)-1;
 }
 
 /** Return non-zero if bitIndex indexes a bit which will be used for a
@@ -130,7 +130,8 @@ hamming_decode(HammingWord encoded, unsigned nParityBits,
     }
   }
   if(errorsyndrome != 0){
-    set_bit(encoded, errorsyndrome, (get_bit(encoded, errorsyndrome)==1) ? 0 : 1);
+    encoded = set_bit(encoded, errorsyndrome,
+                      (get_bit(encoded, errorsyndrome)==1) ? 0 : 1);
     *hasError = 1;
   }
   HammingWord decoded = 0;
@@ -143,3 +144,110 @@ hamming_decode(HammingWord encoded, unsigned nParityBits,
   }
   return decoded;
 }
+
+/************************** Batch Encode/Decode ************************/
+
+/** Masks used by the batch codec for a particular nParityBits. */
+typedef struct {
+  unsigned nParityBits;
+  /** parityMasks[j] has a 1 at every bit whose bitIndex has bit j set;
+   *  i.e. the bits covered by the parity bit at bitIndex 2**j.
+   */
+  HammingWord parityMasks[sizeof(HammingWord)*8];
+} BatchMasks;
+
+static void
+init_batch_masks(BatchMasks *masks, unsigned nParityBits)
+{
+  unsigned nBits = get_n_encoded_bits(nParityBits);
+  masks->nParityBits = nParityBits;
+  for (unsigned j = 0; j < nParityBits; j++) {
+    HammingWord mask = 0;
+    for (unsigned i = 1; i <= nBits; i++) {
+      if (i & (1u << j)) mask = set_bit(mask, i, 1);
+    }
+    masks->parityMasks[j] = mask;
+  }
+}
+
+/** Return parity of all bits in word.  Uses only shifts and xors so
+ *  that loops calling it can be vectorized by the compiler.
+ */
+static inline HammingWord
+word_parity(HammingWord word)
+{
+  word ^= word >> 32; word ^= word >> 16; word ^= word >> 8;
+  word ^= word >> 4; word ^= word >> 2; word ^= word >> 1;
+  return word & 1;
+}
+
+/** The data bits of an encoded word occupy runs of contiguous bit
+ *  positions between consecutive parity positions: run k (k >= 1)
+ *  occupies bitIndex'es 2**k + 1 ... 2**(k+1) - 1.  Hence scattering
+ *  data bits into encoded positions takes one shift per run.
+ */
+static inline HammingWord
+scatter_data(HammingWord data, unsigned nParityBits)
+{
+  HammingWord encoded = 0;
+  unsigned offset = 0;
+  for (unsigned k = 1; k < nParityBits; k++) {
+    unsigned len = (1u << k) - 1;
+    encoded |= ((data >> offset) & ((1ULL << len) - 1)) << (1u << k);
+    offset += len;
+  }
+  return encoded;
+}
+
+/** Inverse of scatter_data(). */
+static inline HammingWord
+gather_data(HammingWord encoded, unsigned nParityBits)
+{
+  HammingWord data = 0;
+  unsigned offset = 0;
+  for (unsigned k = 1; k < nParityBits; k++) {
+    unsigned len = (1u << k) - 1;
+    data |= ((encoded >> (1u << k)) & ((1ULL << len) - 1)) << offset;
+    offset += len;
+  }
+  return data;
+}
+
+void
+hamming_encode_batch(const HammingWord data[], HammingWord encoded[],
+                     size_t n, unsigned nParityBits)
+{
+  BatchMasks masks;
+  init_batch_masks(&masks, nParityBits);
+  for (size_t i = 0; i < n; i++) {
+    HammingWord word = scatter_data(data[i], nParityBits);
+    HammingWord parities = 0;
+    for (unsigned j = 0; j < nParityBits; j++) {
+      parities |= word_parity(word & masks.parityMasks[j]) << ((1u << j) - 1);
+    }
+    encoded[i] = word | parities;
+  }
+}
+
+size_t
+hamming_decode_batch(const HammingWord encoded[], HammingWord decoded[],
+                     size_t n, unsigned nParityBits, unsigned char errors[])
+{
+  BatchMasks masks;
+  init_batch_masks(&masks, nParityBits);
+  size_t nCorrected = 0;
+  for (size_t i = 0; i < n; i++) {
+    HammingWord word = encoded[i];
+    //syndrome is the bitIndex of the erroneous bit, 0 if none
+    HammingWord syndrome = 0;
+    for (unsigned j = 0; j < nParityBits; j++) {
+      syndrome |= word_parity(word & masks.parityMasks[j]) << j;
+    }
+    HammingWord isError = (syndrome != 0);
+    word ^= isError << ((syndrome - isError) & 63);
+    decoded[i] = gather_data(word, nParityBits);
+    if (errors) errors[i] = isError;
+    nCorrected += isError;
+  }
+  return nCorrected;
+}
@@ -1,6 +1,8 @@
 #ifndef HAMMING_H_
 #define HAMMING_H_
 
+#include <stddef.h>
+
 /** A HammingWord contains the encoded data (the original data bits +
  *  the parity bits).
  */
@@ -20,4 +22,18 @@ HammingWord hamming_encode(HammingWord data, unsigned nParityBits);
 HammingWord hamming_decode(HammingWord encoded, unsigned nParityBits,
                            int *hasError);
 
+/** Batch versions of the above which encode data[n] into encoded[n]
+ *  (resp. decode encoded[n] into decoded[n]).  These compute all
+ *  parities with word-wide masks rather than bit-by-bit, and produce
+ *  results identical to calling hamming_encode() / hamming_decode()
+ *  on each word.  If errors is not NULL, hamming_decode_batch() sets
+ *  errors[i] to non-zero iff a single-bit error was corrected in
+ *  encoded[i].  Returns the number of corrected words.
+ */
+void hamming_encode_batch(const HammingWord data[], HammingWord encoded[],
+                          size_t n, unsigned nParityBits);
+size_t hamming_decode_batch(const HammingWord encoded[], HammingWord decoded[],
+                            size_t n, unsigned nParityBits,
+                            unsigned char errors[]);
+
 #endif //ifndef HAMMING_H_
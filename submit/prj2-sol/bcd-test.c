@@ -421,6 +421,32 @@ START_TEST(str_to_bcd_not_nul_terminator)
 }
 END_TEST
 
+START_TEST(str_to_bcd_page_end)
+{
+  //digits ending just before a page boundary cannot be loaded as a
+  //16-byte vector
+  enum { PAGE_SIZE = 4096 };
+  char *pages = aligned_alloc(PAGE_SIZE, 2*PAGE_SIZE);
+  char *str = &pages[PAGE_SIZE - BCD_BUF_SIZE];
+  strcpy(str, DATA.consecutive.str);
+  TEST_TRACE("str_to_bcd(\"%s\"): at page end", str);
+
+  const char *p;
+  BcdError err = OK_ERR;
+  Bcd result = str_to_bcd(str, &p, &err);
+
+  BCD_TRACE(result, DATA.consecutive.bcd);
+  ck_assert_bcd_eq(result, DATA.consecutive.bcd);
+
+  CHAR_TRACE(*p, '\0');
+  ck_assert_int_eq(*p, '\0');
+
+  ERR_TRACE(err, OK_ERR);
+  ck_assert_int_eq(err, OK_ERR);
+  free(pages);
+}
+END_TEST
+
 START_TEST(str_to_bcd_max)
 {
   TEST_TRACE("str_to_bcd(\"%s\")", DATA.max.str);
@@ -464,6 +490,7 @@ add_str_to_bcd_tests(Suite *suite)
   TCase *strToBcd = tcase_create("str_to_bcd");
   tcase_add_test(strToBcd, str_to_bcd_consecutive);
   tcase_add_test(strToBcd, str_to_bcd_not_nul_terminator);
+  tcase_add_test(strToBcd, str_to_bcd_page_end);
   tcase_add_test(strToBcd, str_to_bcd_max);
   tcase_add_test(strToBcd, str_to_bcd_overflow);
   suite_add_tcase(suite, strToBcd);
@@ -945,6 +972,136 @@ add_bcd_multiop_tests(Suite *suite)
   suite_add_tcase(suite, multiop);
 
 }
+/************************** Batch (Column) Tests ***********************/
+
+//spans more than one BcdErrorBits word and ends in a partial vector
+enum { N_BATCH = 100 };
+
+static int
+error_bit(const BcdErrorBits errors[], size_t i)
+{
+  return (errors[i / 64] >> (i % 64)) & 1;
+}
+
+/** Fill x[N_BATCH] with a mix of the test data values. */
+static void
+fill_batch(Bcd x[])
+{
+  const Bcd values[] = {
+    DATA.zero.bcd, DATA.consecutive.bcd, DATA.max.bcd, DATA.max4.bcd,
+    DATA.maxHalfTrunc.bcd, DATA.maxHalfRound.bcd, DATA.badVal.bcd, 0x1,
+  };
+  enum { N_VALUES = sizeof(values)/sizeof(values[0]) };
+  for (int i = 0; i < N_BATCH; i++) {
+    x[i] = values[(i*3 + i/N_VALUES) % N_VALUES];
+  }
+}
+
+START_TEST(bcd_add_n_matches_scalar)
+{
+  TEST_TRACE("bcd_add_n() of %d elements", N_BATCH);
+  Bcd x[N_BATCH], y[N_BATCH], z[N_BATCH];
+  BcdErrorBits errors[BCD_ERROR_BITS_WORDS(N_BATCH)];
+  fill_batch(x);
+  for (int i = 0; i < N_BATCH; i++) y[i] = x[N_BATCH - 1 - i];
+
+  size_t nErrors = bcd_add_n(x, y, z, N_BATCH, errors);
+
+  size_t nExpected = 0;
+  for (int i = 0; i < N_BATCH; i++) {
+    BcdError err = OK_ERR;
+    Bcd sum = bcd_add(x[i], y[i], &err);
+    ck_assert_int_eq(error_bit(errors, i), err != OK_ERR);
+    ck_assert_bcd_eq(z[i], err == OK_ERR ? sum : 0);
+    nExpected += err != OK_ERR;
+  }
+  ck_assert_int_eq(nErrors, nExpected);
+}
+END_TEST
+
+START_TEST(bcd_mul_small_n_matches_scalar)
+{
+  const unsigned multipliers[] = { 0, 1, 2, 7, 10 };
+  Bcd x[N_BATCH], z[N_BATCH];
+  BcdErrorBits errors[BCD_ERROR_BITS_WORDS(N_BATCH)];
+  fill_batch(x);
+  for (size_t k = 0; k < sizeof(multipliers)/sizeof(multipliers[0]); k++) {
+    unsigned m = multipliers[k];
+    TEST_TRACE("bcd_mul_small_n(x, %u) of %d elements", m, N_BATCH);
+
+    size_t nErrors = bcd_mul_small_n(x, m, z, N_BATCH, errors);
+
+    size_t nExpected = 0;
+    for (int i = 0; i < N_BATCH; i++) {
+      BcdError err = OK_ERR;
+      Bcd product = bcd_multiply(x[i], binary_to_bcd(m, NULL), &err);
+      ck_assert_int_eq(error_bit(errors, i), err != OK_ERR);
+      ck_assert_bcd_eq(z[i], err == OK_ERR ? product : 0);
+      nExpected += err != OK_ERR;
+    }
+    ck_assert_int_eq(nErrors, nExpected);
+  }
+}
+END_TEST
+
+START_TEST(bcd_sum_reduce_carry)
+{
+  TEST_TRACE("bcd_sum_reduce() of 99 1's");
+  Bcd x[99];
+  for (int i = 0; i < 99; i++) x[i] = 0x1;
+  BcdError err = OK_ERR;
+  Bcd sum = bcd_sum_reduce(x, 99, NULL, &err);
+
+  BCD_TRACE(sum, (Bcd)0x99);
+  ck_assert_bcd_eq(sum, 0x99);
+
+  ERR_TRACE(err, OK_ERR);
+  ck_assert_int_eq(err, OK_ERR);
+}
+END_TEST
+
+START_TEST(bcd_sum_reduce_bad_value)
+{
+  TEST_TRACE("bcd_sum_reduce() with bad element");
+  Bcd x[] = { 0x1, DATA.badVal.bcd, 0x2 };
+  BcdErrorBits errors[1];
+  BcdError err = OK_ERR;
+  Bcd sum = bcd_sum_reduce(x, 3, errors, &err);
+
+  BCD_TRACE(sum, (Bcd)0x3);
+  ck_assert_bcd_eq(sum, 0x3);
+  ck_assert_int_eq(errors[0], 0x2);
+
+  ERR_TRACE(err, BAD_VALUE_ERR);
+  ck_assert_int_eq(err, BAD_VALUE_ERR);
+}
+END_TEST
+
+START_TEST(bcd_sum_reduce_overflow)
+{
+  TEST_TRACE("bcd_sum_reduce() overflow");
+  Bcd x[] = { DATA.max4.bcd, 0x3, 0x2 };
+  BcdError err = OK_ERR;
+  bcd_sum_reduce(x, 3, NULL, &err);
+
+  ERR_TRACE(err, OVERFLOW_ERR);
+  ck_assert_int_eq(err, OVERFLOW_ERR);
+}
+END_TEST
+
+__attribute__((unused))
+static void
+add_bcd_batch_tests(Suite *suite)
+{
+  TCase *batch = tcase_create("batch");
+  tcase_add_test(batch, bcd_add_n_matches_scalar);
+  tcase_add_test(batch, bcd_mul_small_n_matches_scalar);
+  tcase_add_test(batch, bcd_sum_reduce_carry);
+  tcase_add_test(batch, bcd_sum_reduce_bad_value);
+  tcase_add_test(batch, bcd_sum_reduce_overflow);
+  suite_add_tcase(suite, batch);
+}
+
 /*********************** Test Suite and Runner *************************/
 
 #define binary_to_bcd_test 0x1
@@ -954,13 +1111,15 @@ add_bcd_multiop_tests(Suite *suite)
 #define bcd_add_test 0x10
 #define bcd_multiply_test 0x20
 #define bcd_multiop_test 0x40
+#define bcd_batch_test 0x80
 
 #if TEST == 0
 #undef TEST
 #define TEST \
   (binary_to_bcd_test | bcd_to_binary_test | \
    str_to_bcd_test | bcd_to_str_test | \
-   bcd_add_test | bcd_multiply_test | bcd_multiop_test )
+   bcd_add_test | bcd_multiply_test | bcd_multiop_test | \
+   bcd_batch_test )
 #endif
 
 static Suite *
@@ -989,6 +1148,9 @@ bcd_suite(const char *name)
   #if TEST & bcd_multiop_test
   add_bcd_multiop_tests(suite);
   #endif
+  #if TEST & bcd_batch_test
+  add_bcd_batch_tests(suite);
+  #endif
 
   return suite;
 }
@@ -1,25 +1,20 @@
 #include "bcd.h"
+#include "bcdkernels.h"
 
 #include <assert.h>
 #include <ctype.h>
 #include <limits.h>
 #include <stdio.h>
 #include <math.h>
-#include <ctype.h>
+#include <string.h>
 
-Bcd
-get_bcd_digit(Bcd val, int indx){
-	val = val >> (indx*4);
-	val = val & (Bcd)(0xf);
-	return val;
-}
+enum { BCD_TYPE_BITS = MAX_BCD_DIGITS * BCD_BITS };
 
-Bcd
-set_bcd_digit(Bcd bcd, int indx, Bcd nbcd){
-	bcd &= ~(((Bcd)(0xf)) << (indx*4));
-	bcd |= (nbcd << (indx*4));
-	return bcd;
-}
+//all ones over the width of a Bcd
+#define BCD_WIDE_MASK ((BcdWide)(Bcd)~(Bcd)0)
+
+//0x11...1 over the width of a Bcd: a 1 in the LSB of each digit
+#define BCD_NIBBLE_ONES (BCD_WIDE_MASK / 0xf)
 
 /** Return BCD encoding of binary (which has normal binary representation).
  *
@@ -31,30 +26,26 @@ set_bcd_digit(Bcd bcd, int indx, Bcd nbcd){
  */
 Bcd
 binary_to_bcd(Binary value, BcdError *error)
-{		
-	int index = 0;
-	Bcd ret = 0;
-
-	while (value > 0)
+{
+	//peel off 4 decimal digits per iteration; division by the
+	//constant 10000 compiles to a multiply by its reciprocal
+	BcdWide v = value;
+	BcdWide ret = 0;
+	for (unsigned shift = 0; v != 0 && shift < BCD_TYPE_BITS; shift += 16)
 	{
-		ret = set_bcd_digit(ret, index, value % 10);
-		value = value / 10;
-		index++;
+		BcdWide q = v / 10000;
+		ret |= bcd4(v - q*10000) << shift;
+		v = q;
 	}
-	
-	if (index > MAX_BCD_DIGITS)
+
+	if ((v != 0 || (ret & ~BCD_WIDE_MASK) != 0) && error != NULL)
 	{
-		if (error != NULL)
-		{
 		*error = OVERFLOW_ERR;
-		}
 	}
-	return ret;
+	return ret & BCD_WIDE_MASK;
 }
 
-/** Return binary encodin
-
-g of BCD value bcd.
+/** Return binary encoding of BCD value bcd.
  *
  *  Examples: bcd_to_binary(0x12) => 0xc;
  *            bcd_to_binary(0x255) => 0xff
@@ -66,26 +57,30 @@ g of BCD value bcd.
 Binary
 bcd_to_binary(Bcd bcd, BcdError *error)
 {
-	Binary ret = 0;
-	Bcd test = 0;
-	long i = 1;
-	
-	while (bcd > 0)
-	{
-		test = get_bcd_digit(bcd, 0);
-		bcd >>= 4;
-		if (error != NULL)
-		{
-			if (test > 9)
-			{
-				*error = BAD_VALUE_ERR;
-				break;
-			}
-		}
-		ret += test*(i);
-		i*=10;
+	if (error != NULL && bad_digits(bcd))
+	{
+		*error = BAD_VALUE_ERR;
+	}
+
+	//combine adjacent lanes pairwise as hi*10**n + lo, doubling the
+	//lane width each step: digits -> 2-digit bytes -> 4-digit
+	//shorts -> 8-digit words -> result.
+	BcdWide x = bcd;
+	x = (x & 0x0F0F0F0F0F0F0F0FULL) + ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL)*10;
+	if (BCD_TYPE_BITS > 8)
+	{
+		x = (x & 0x00FF00FF00FF00FFULL) + ((x >> 8) & 0x00FF00FF00FF00FFULL)*100;
+	}
+	if (BCD_TYPE_BITS > 16)
+	{
+		x = (x & 0x0000FFFF0000FFFFULL) +
+			((x >> 16) & 0x0000FFFF0000FFFFULL)*10000;
+	}
+	if (BCD_TYPE_BITS > 32)
+	{
+		x = (x & 0x00000000FFFFFFFFULL) + (x >> 32)*100000000;
 	}
-	return ret;
+	return x;
 }
 
 /** Return BCD encoding of decimal number corresponding to string s.
@@ -99,31 +94,34 @@ bcd_to_binary(Bcd bcd, BcdError *error)
 Bcd
 str_to_bcd(const char *s, const char **p, BcdError *error)
 {
-	Binary ret = 0;
-	*p = s;
-	int carryOut = 0;
-
-	for(int count = 0; s[count] != '\0' ; count++)
-	{		
-		if(s[count] >= '0' && s[count] <= '9')
-		{   
-			ret *= 10;
-			ret += s[count] - '0';
-			++(*p);
-			carryOut++;
-		}
-		else
+	const char *q = s;
+	BcdWide ret = 0;
+	int nDigits = 0;
+
+#ifdef __SSE2__
+	int isVector = can_load16(q);
+	if (isVector)
+	{
+		nDigits = pack16_digits(q, &ret);
+		q += nDigits;
+	}
+	if (!isVector || nDigits == ASCII_VEC_SIZE)
+#endif
+	{
+		//near a page end, or counting digits beyond the vector on
+		//overflow
+		for (; *q >= '0' && *q <= '9'; q++, nDigits++)
 		{
-			break;
+			ret = (ret << BCD_BITS) | (BcdWide)(*q - '0');
 		}
 	}
 
-	if(error != NULL && carryOut > MAX_BCD_DIGITS)
+	*p = q;
+	if (error != NULL && nDigits > MAX_BCD_DIGITS)
 	{
 		*error = OVERFLOW_ERR;
 	}
-
-	return binary_to_bcd(ret, error);
+	return ret & BCD_WIDE_MASK;
 }
 
 /** Convert bcd to a NUL-terminated string in buf[] without any
@@ -138,32 +136,28 @@ str_to_bcd(const char *s, const char **p, BcdError *error)
 int
 bcd_to_str(Bcd bcd, char buf[], size_t bufSize, BcdError *error)
 {
-	int written = 0;
-	
 	if (bufSize < BCD_BUF_SIZE)
 	{
-		*error = OVERFLOW_ERR;
+		if (error != NULL) *error = OVERFLOW_ERR;
+		return 0;
 	}
-	else
+	if (bad_digits(bcd))
 	{
-		for (int i =0; i<bufSize;i++)
-		{
-			Binary digit = get_bcd_digit(bcd, i);
-			if (digit < 10)
-			{
-				written = snprintf(buf, bufSize, "%" BCD_FORMAT_MODIFIER "x", bcd);
-			}
-			if (digit > 9 && error != NULL)
-			{
-				*error = BAD_VALUE_ERR;
-			}
-			if (error != NULL && bufSize < BCD_BUF_SIZE)
-			{
-				*error = OVERFLOW_ERR;
-			}
-		}
+		if (error != NULL) *error = BAD_VALUE_ERR;
+		return 0;
 	}
-  return written;
+
+	//# of significant digits: at least 1 so that 0 prints as "0"
+	BcdWide wide = bcd;
+	int nSig = (wide == 0) ? 1 :
+		(int)sizeof(BcdWide)*2 - __builtin_clzll(wide)/BCD_BITS;
+
+	//unpack all 16 nibbles of wide, most significant first
+	char digits[ASCII_VEC_SIZE];
+	unpack16_digits(wide, digits);
+	memcpy(buf, &digits[ASCII_VEC_SIZE - nSig], nSig);
+	buf[nSig] = '\0';
+	return nSig;
 }
 
 /** Return the BCD representation of the sum of BCD int's x and y.
@@ -174,11 +168,32 @@ bcd_to_str(Bcd bcd, char buf[], size_t bufSize, BcdError *error)
  */
 Bcd
 bcd_add(Bcd x, Bcd y, BcdError *error)
-{	
-	Binary bin_x = bcd_to_binary(x, error);
-    Binary bin_y = bcd_to_binary(y, error);
-	
-    return binary_to_bcd(bin_x + bin_y, error);
+{
+	//bias every digit of x by 6 so that a decimal carry out of a
+	//digit shows up as a binary carry out of its nibble
+	BcdWide biased = (BcdWide)x + BCD_NIBBLE_ONES*6;
+	BcdWide sum = biased + y;
+	BcdWide carryIns = biased ^ y ^ sum;
+	BcdWide carryOut = (sum < biased) | ((sum & ~BCD_WIDE_MASK) != 0);
+
+	//nibbles which did not carry out still hold digit + 6: undo bias
+	BcdWide noCarry = (~carryIns >> BCD_BITS) & BCD_NIBBLE_ONES &
+		(BCD_WIDE_MASK >> BCD_BITS);
+	noCarry |= (carryOut ^ 1) << (BCD_TYPE_BITS - BCD_BITS);
+	Bcd result = (sum - noCarry*6) & BCD_WIDE_MASK;
+
+	if (error != NULL)
+	{
+		if (bad_digits(x) | bad_digits(y))
+		{
+			*error = BAD_VALUE_ERR;
+		}
+		else if (carryOut)
+		{
+			*error = OVERFLOW_ERR;
+		}
+	}
+	return result;
 }
 
 /** Return the BCD representation of the product of BCD int's x and y.
@@ -190,8 +205,315 @@ bcd_add(Bcd x, Bcd y, BcdError *error)
 Bcd
 bcd_multiply(Bcd x, Bcd y, BcdError *error)
 {
-	Binary bin_x = bcd_to_binary (x, error);
-	Binary bin_y = bcd_to_binary (y, error); 
-	
-	return binary_to_bcd (bin_x * bin_y, error);
+	BcdError convError = OK_ERR;
+	BcdWide bin_x = bcd_to_binary(x, &convError);
+	BcdWide bin_y = bcd_to_binary(y, &convError);
+	if (convError != OK_ERR)
+	{
+		if (error != NULL) *error = convError;
+		return 0;
+	}
+
+	//product of two Binary's may not fit in a BcdWide
+	if (bin_y != 0 && bin_x > (BcdWide)BCD_WIDE_MASK / bin_y)
+	{
+		if (error != NULL) *error = OVERFLOW_ERR;
+		return 0;
+	}
+	BcdWide product = bin_x * bin_y;
+	if (product > (BcdWide)(Binary)~(Binary)0)
+	{
+		if (error != NULL) *error = OVERFLOW_ERR;
+		return 0;
+	}
+	return binary_to_bcd(product, error);
+}
+
+/************************* Batch (Column) API **************************/
+
+//The batch operations work on vectors of BCD_LANES Bcd's using GCC
+//vector extensions: each lane has the width of a Bcd, so decimal
+//carries cannot leak between elements.  A 32-byte vector is a single
+//AVX2 register; without AVX2 the compiler splits it into SSE2 halves.
+enum { BCD_VEC_BYTES = 32, BCD_LANES = BCD_VEC_BYTES / sizeof(Bcd) };
+typedef Bcd BcdVec __attribute__((vector_size(BCD_VEC_BYTES)));
+
+//# of vectors covering the 64 elements of one BcdErrorBits word
+enum { VECS_PER_ERROR_WORD = 64 / BCD_LANES };
+
+//compile the batch loops for AVX2 as well as for the baseline ISA and
+//let the dynamic loader pick one for the running CPU
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+  #define BCD_BATCH_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+  #define BCD_BATCH_CLONES
+#endif
+
+//vectors are never passed between functions, even when not optimizing
+#define BCD_VEC_INLINE inline __attribute__((always_inline))
+
+//the helpers below take vectors by pointer: 32-byte vectors passed by
+//value have a different ABI with and without AVX
+
+/** Set all bits of *bad in the lanes of *x which contain a digit > 9. */
+static BCD_VEC_INLINE void
+vec_flag_bad(const BcdVec *x, BcdVec *bad)
+{
+	BcdVec b = *x & ((*x << 1) | (*x << 2)) & (Bcd)(BCD_NIBBLE_ONES*8);
+	*bad |= (BcdVec)(b != 0);
+}
+
+/** Set *z to the lane-wise BCD sum *x + *y of valid vectors, and set
+ *  all bits of *overflow in the lanes which carried out.  Same decimal
+ *  adjust as bcd_add().  z may point to x or y.
+ */
+static BCD_VEC_INLINE void
+vec_add(BcdVec *z, const BcdVec *x, const BcdVec *y, BcdVec *overflow)
+{
+	BcdVec biased = *x + (Bcd)(BCD_NIBBLE_ONES*6);
+	BcdVec sum = biased + *y;
+	BcdVec carryOut = (BcdVec)(sum < biased);
+	BcdVec carryIns = biased ^ *y ^ sum;
+	BcdVec noCarry = (~carryIns >> BCD_BITS) &
+		(Bcd)(BCD_NIBBLE_ONES >> BCD_BITS);
+	noCarry |= ~carryOut & (Bcd)((BcdWide)1 << (BCD_TYPE_BITS - BCD_BITS));
+	*overflow |= carryOut;
+	*z = sum - noCarry*6;
+}
+
+/** Return bits [offset, offset + BCD_LANES) set for the lanes of
+ *  *errors which are set.  Lanes must be all ones or all zeros.
+ */
+static BCD_VEC_INLINE BcdErrorBits
+lane_bits(const BcdVec *errors, unsigned offset)
+{
+	BcdErrorBits bits = 0;
+#ifdef __SSE2__
+	//movemask the two 16-byte halves at the granularity of a lane
+	__m128i half[2];
+	memcpy(half, errors, sizeof(half));
+	switch (sizeof(Bcd))
+	{
+	case 1:
+		bits = _mm_movemask_epi8(half[0]) |
+			(unsigned)_mm_movemask_epi8(half[1]) << 16;
+		break;
+	case 2:
+		bits = _mm_movemask_epi8(_mm_packs_epi16(half[0], half[1]));
+		break;
+	case 4:
+		bits = _mm_movemask_ps(_mm_castsi128_ps(half[0])) |
+			_mm_movemask_ps(_mm_castsi128_ps(half[1])) << 4;
+		break;
+	default:
+		bits = _mm_movemask_pd(_mm_castsi128_pd(half[0])) |
+			_mm_movemask_pd(_mm_castsi128_pd(half[1])) << 2;
+		break;
+	}
+#else
+	for (int k = 0; k < BCD_LANES; k++)
+	{
+		bits |= (BcdErrorBits)((*errors)[k] & 1) << k;
+	}
+#endif
+	return bits << offset;
+}
+
+/** Set *v to a[i, i + BCD_LANES), zero-filled past n. */
+static BCD_VEC_INLINE void
+vec_load(BcdVec *v, const Bcd a[], size_t i, size_t n)
+{
+	if (n - i >= BCD_LANES)
+	{
+		memcpy(v, &a[i], sizeof(*v));  //constant size: one load
+	}
+	else
+	{
+		memset(v, 0, sizeof(*v));
+		memcpy(v, &a[i], (n - i) * sizeof(Bcd));
+	}
+}
+
+/** Store lanes of *v into a[i, min(i + BCD_LANES, n)). */
+static BCD_VEC_INLINE void
+vec_store(Bcd a[], size_t i, size_t n, const BcdVec *v)
+{
+	if (n - i >= BCD_LANES)
+	{
+		memcpy(&a[i], v, sizeof(*v));
+	}
+	else
+	{
+		memcpy(&a[i], v, (n - i) * sizeof(Bcd));
+	}
+}
+
+/** Set z[i] to the BCD sum x[i] + y[i] for i in [0, n). */
+BCD_BATCH_CLONES size_t
+bcd_add_n(const Bcd x[], const Bcd y[], Bcd z[], size_t n,
+	  BcdErrorBits errors[])
+{
+	size_t nErrors = 0;
+	for (size_t w = 0; w < BCD_ERROR_BITS_WORDS(n); w++)
+	{
+		BcdErrorBits bits = 0;
+		for (unsigned v = 0; v < VECS_PER_ERROR_WORD; v++)
+		{
+			size_t i = w*64 + v*BCD_LANES;
+			if (i >= n) break;
+			BcdVec vx, vy, sum, bad = { 0 };
+			vec_load(&vx, x, i, n);
+			vec_load(&vy, y, i, n);
+			vec_flag_bad(&vx, &bad);
+			vec_flag_bad(&vy, &bad);
+			vec_add(&sum, &vx, &vy, &bad);
+			sum &= ~bad;
+			vec_store(z, i, n, &sum);
+			bits |= lane_bits(&bad, v*BCD_LANES);
+		}
+		errors[w] = bits;
+		nErrors += __builtin_popcountll(bits);
+	}
+	return nErrors;
+}
+
+/** Set z[i] to the BCD product x[i] * m for i in [0, n). */
+BCD_BATCH_CLONES size_t
+bcd_mul_small_n(const Bcd x[], unsigned m, Bcd z[], size_t n,
+		BcdErrorBits errors[])
+{
+	size_t nErrors = 0;
+	for (size_t w = 0; w < BCD_ERROR_BITS_WORDS(n); w++)
+	{
+		BcdErrorBits bits = 0;
+		for (unsigned v = 0; v < VECS_PER_ERROR_WORD; v++)
+		{
+			size_t i = w*64 + v*BCD_LANES;
+			if (i >= n) break;
+			BcdVec power, product = { 0 }, bad = { 0 };  //power: x * 2**k
+			vec_load(&power, x, i, n);
+			vec_flag_bad(&power, &bad);
+
+			//binary method: every doubling is needed by a later
+			//add, so any carry out means the product overflows
+			for (unsigned k = m; k != 0; k >>= 1)
+			{
+				if (k & 1) vec_add(&product, &product, &power, &bad);
+				if (k > 1) vec_add(&power, &power, &power, &bad);
+			}
+			product &= ~bad;
+			vec_store(z, i, n, &product);
+			bits |= lane_bits(&bad, v*BCD_LANES);
+		}
+		errors[w] = bits;
+		nErrors += __builtin_popcountll(bits);
+	}
+	return nErrors;
+}
+
+//bcd_sum_reduce() views x[] as a stream of BcdWide's, each holding
+//BCDS_PER_WIDE consecutive elements, and sums each of the 16 nibble
+//columns separately in binary.  The even and odd nibbles are spread
+//into the bytes of two accumulators; a byte can absorb
+//MAX_COLUMN_ADDS digits before it must be flushed to the 64-bit
+//column sums.
+enum {
+	BCDS_PER_WIDE = sizeof(BcdWide) / sizeof(Bcd),
+	WIDE_DIGITS = sizeof(BcdWide) * CHAR_BIT / BCD_BITS,
+	MAX_COLUMN_ADDS = UCHAR_MAX / 9
+};
+
+#define BCD_WIDE_LOW_NIBBLES 0x0f0f0f0f0f0f0f0fULL
+
+/** Add the digit sums held in the bytes of even and odd into the
+ *  columns[WIDE_DIGITS] sums.
+ */
+static void
+flush_columns(BcdWide even, BcdWide odd, unsigned long long columns[])
+{
+	for (int k = 0; k < WIDE_DIGITS/2; k++)
+	{
+		columns[2*k] += (even >> (8*k)) & 0xff;
+		columns[2*k + 1] += (odd >> (8*k)) & 0xff;
+	}
+}
+
+/** Return the BCD sum of x[0, n). */
+Bcd
+bcd_sum_reduce(const Bcd x[], size_t n, BcdErrorBits errors[],
+	       BcdError *error)
+{
+	unsigned long long columns[WIDE_DIGITS] = { 0 };
+	BcdWide even = 0, odd = 0;
+	int nAdds = 0;
+	int hasBad = 0;
+	if (errors != NULL)
+	{
+		memset(errors, 0, BCD_ERROR_BITS_WORDS(n) * sizeof(errors[0]));
+	}
+	for (size_t i = 0; i < n; i += BCDS_PER_WIDE)
+	{
+		BcdWide wide = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		if (n - i >= BCDS_PER_WIDE)
+		{
+			memcpy(&wide, &x[i], sizeof(wide));  //same layout
+		}
+		else
+#endif
+		for (size_t j = 0; j < BCDS_PER_WIDE && i + j < n; j++)
+		{
+			wide |= (BcdWide)x[i + j] << (j * BCD_TYPE_BITS);
+		}
+		if (bad_digits(wide))
+		{
+			//rare: drop the offending elements from the sum
+			for (size_t j = 0; j < BCDS_PER_WIDE && i + j < n; j++)
+			{
+				if (!bad_digits(x[i + j])) continue;
+				wide &= ~(BCD_WIDE_MASK << (j * BCD_TYPE_BITS));
+				if (errors != NULL)
+				{
+					errors[(i + j) / 64] |= 1ULL << ((i + j) % 64);
+				}
+				hasBad = 1;
+			}
+		}
+		even += wide & BCD_WIDE_LOW_NIBBLES;
+		odd += (wide >> BCD_BITS) & BCD_WIDE_LOW_NIBBLES;
+		if (++nAdds == MAX_COLUMN_ADDS)
+		{
+			flush_columns(even, odd, columns);
+			even = odd = 0;
+			nAdds = 0;
+		}
+	}
+	flush_columns(even, odd, columns);
+
+	//nibble k of a BcdWide is digit k % MAX_BCD_DIGITS of its element;
+	//fold the columns and normalize with a single carry pass
+	unsigned long long carry = 0;
+	Bcd result = 0;
+	for (int d = 0; d < MAX_BCD_DIGITS; d++)
+	{
+		unsigned long long sum = carry;
+		for (int k = d; k < WIDE_DIGITS; k += MAX_BCD_DIGITS)
+		{
+			sum += columns[k];
+		}
+		result |= (Bcd)((BcdWide)(sum % 10) << (d * BCD_BITS));
+		carry = sum / 10;
+	}
+	if (error != NULL)
+	{
+		if (hasBad)
+		{
+			*error = BAD_VALUE_ERR;
+		}
+		else if (carry != 0)
+		{
+			*error = OVERFLOW_ERR;
+		}
+	}
+	return result;
 }
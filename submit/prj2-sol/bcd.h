@@ -50,6 +50,36 @@
 // printf("%" BCD_FORMAT_MODIFIER "u", bcd);   //output in decimal
 // scanf("%" SCANF_MODIFIER "x", &bcd);        //read from stdin to bcd
 
+//When BCD_SUFFIXED_NAMES is defined (as when building libbcd.a,
+//which contains every width), the API functions declared below get
+//a suffix naming the width of Bcd so that several widths can be
+//linked into one program: e.g. bcd_add() becomes bcd_add_u16() when
+//BCD_BASE == 1.  Clients of libbcd.a should use bcdgeneric.h.
+#ifdef BCD_SUFFIXED_NAMES
+  #if BCD_BASE == 0
+    #define BCD_SUFFIX u8
+  #elif BCD_BASE == 1
+    #define BCD_SUFFIX u16
+  #elif BCD_BASE == 2
+    #define BCD_SUFFIX u32
+  #elif BCD_BASE == 4
+    #define BCD_SUFFIX u64
+  #else
+    #error "BCD_SUFFIXED_NAMES not supported for this BCD_BASE"
+  #endif
+  #define BCD_PASTE_(name, suffix) name##_##suffix
+  #define BCD_PASTE(name, suffix) BCD_PASTE_(name, suffix)
+  #define binary_to_bcd BCD_PASTE(binary_to_bcd, BCD_SUFFIX)
+  #define bcd_to_binary BCD_PASTE(bcd_to_binary, BCD_SUFFIX)
+  #define str_to_bcd BCD_PASTE(str_to_bcd, BCD_SUFFIX)
+  #define bcd_to_str BCD_PASTE(bcd_to_str, BCD_SUFFIX)
+  #define bcd_add BCD_PASTE(bcd_add, BCD_SUFFIX)
+  #define bcd_multiply BCD_PASTE(bcd_multiply, BCD_SUFFIX)
+  #define bcd_add_n BCD_PASTE(bcd_add_n, BCD_SUFFIX)
+  #define bcd_mul_small_n BCD_PASTE(bcd_mul_small_n, BCD_SUFFIX)
+  #define bcd_sum_reduce BCD_PASTE(bcd_sum_reduce, BCD_SUFFIX)
+#endif
+
 //use same C-type as Bcd to represent binary representation of a Bcd number
 typedef Bcd Binary;
 
@@ -65,11 +95,7 @@ enum {
 };
 
 //error codes returned by following API
-typedef enum {
-  OK_ERR,                  //no error
-  BAD_VALUE_ERR,           //binary BCD value contains a digit > 9
-  OVERFLOW_ERR             //an overflow was detected
-} BcdError;
+#include "bcderror.h"
 
 
 
@@ -131,4 +157,40 @@ Bcd bcd_add(Bcd x, Bcd y, BcdError *error);
  */
 Bcd bcd_multiply(Bcd x, Bcd y, BcdError *error);
 
+
+/************************* Batch (Column) API **************************/
+
+//The following operate on arrays of n Bcd's, many lanes per
+//instruction.  Instead of a single BcdError, they fill in errors[],
+//which must have room for BCD_ERROR_BITS_WORDS(n) words: the bit for
+//element i is set if that element had a bad BCD digit or overflowed.
+//bcd_add_n() and bcd_mul_small_n() set the result for such an element
+//to 0 and return the number of elements in error.
+
+/** Set z[i] to the BCD sum x[i] + y[i] for i in [0, n).  z may be the
+ *  same array as x or y.
+ */
+size_t bcd_add_n(const Bcd x[], const Bcd y[], Bcd z[], size_t n,
+                 BcdErrorBits errors[]);
+
+/** Set z[i] to the BCD product x[i] * m for i in [0, n), where m is an
+ *  ordinary binary multiplier.  Uses O(log m) decimal additions per
+ *  element, so is intended for small m (e.g. scaling by 10 or 100).
+ *  z may be the same array as x.
+ */
+size_t bcd_mul_small_n(const Bcd x[], unsigned m, Bcd z[], size_t n,
+                       BcdErrorBits errors[]);
+
+/** Return the BCD sum of x[0, n).  Elements with a bad BCD digit are
+ *  flagged in errors[] (if not NULL) and excluded from the sum.  Digit
+ *  columns are accumulated in binary and only carried once, at the end.
+ *
+ *  If error is not NULL, sets *error to BAD_VALUE_ERR if some element
+ *  contains a BCD digit which is greater than 9, OVERFLOW_ERR if the
+ *  sum of the remaining elements does not fit in a Bcd, otherwise
+ *  *error is unchanged.
+ */
+Bcd bcd_sum_reduce(const Bcd x[], size_t n, BcdErrorBits errors[],
+                   BcdError *error);
+
 #endif //ifndef BCD_H_
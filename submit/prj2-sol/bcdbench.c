@@ -0,0 +1,317 @@
+#define _POSIX_C_SOURCE 200809L  //for clock_gettime()
+
+#include "bcd.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Microbenchmark for the BCD API at one BCD_BASE.  Each operation is
+ *  timed over N_OPS precomputed inputs, N_SAMPLES times after one
+ *  warmup pass, on two input sets:
+ *
+ *    random: uniformly random values which fit in a Bcd (for
+ *            bcd_multiply(), operands with at most half the digits so
+ *            that most products fit);
+ *    nines:  all digits 9, the worst case for carries (bcd_add() and
+ *            bcd_multiply() overflow).
+ *
+ *  Reports the mean ns/op and its 95% confidence interval over the
+ *  samples, as a table or (with -j) as one JSON object per line, for
+ *  tracking regressions across commits.
+ */
+
+enum {
+  DEFAULT_N_OPS = 1 << 16,
+  DEFAULT_N_SAMPLES = 20,
+};
+
+typedef struct {
+  size_t n;
+  Binary *binary;               //binary values
+  Bcd *x, *y;                   //BCD operands
+  char (*str)[BCD_BUF_SIZE];    //string representations of x
+} Inputs;
+
+/** xorshift64* PRNG: deterministic across platforms given a seed. */
+static unsigned long long
+next_rand(unsigned long long *state)
+{
+  unsigned long long x = *state;
+  x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+/** Return random binary value with at most nDigits decimal digits. */
+static Binary
+random_binary(int nDigits, unsigned long long *seed)
+{
+  unsigned long long limit = 1;
+  for (int i = 0; i < nDigits; i++) limit *= 10;
+  return next_rand(seed) % limit;
+}
+
+static void *
+must_malloc(size_t size)
+{
+  void *p = malloc(size);
+  if (!p) {
+    fprintf(stderr, "cannot allocate %zu bytes\n", size);
+    exit(1);
+  }
+  return p;
+}
+
+/** Fill in in with n inputs; random if seed is not NULL, else all 9's.
+ *  nOperandDigits is the # of digits in random x and y.
+ */
+static void
+make_inputs(Inputs *in, size_t n, int nOperandDigits,
+            unsigned long long *seed)
+{
+  in->n = n;
+  in->binary = must_malloc(n * sizeof(Binary));
+  in->x = must_malloc(n * sizeof(Bcd));
+  in->y = must_malloc(n * sizeof(Bcd));
+  in->str = must_malloc(n * sizeof(in->str[0]));
+  Binary max = 0;
+  for (int i = 0; i < MAX_BCD_DIGITS; i++) max = max*10 + 9;
+  for (size_t i = 0; i < n; i++) {
+    Binary xBinary = seed ? random_binary(nOperandDigits, seed) : max;
+    Binary yBinary = seed ? random_binary(nOperandDigits, seed) : max;
+    in->binary[i] = seed ? random_binary(MAX_BCD_DIGITS, seed) : max;
+    in->x[i] = binary_to_bcd(xBinary, NULL);
+    in->y[i] = binary_to_bcd(yBinary, NULL);
+    bcd_to_str(in->x[i], in->str[i], BCD_BUF_SIZE, NULL);
+  }
+}
+
+static void
+free_inputs(Inputs *in)
+{
+  free(in->binary); free(in->x); free(in->y); free(in->str);
+}
+
+//each benchmarked loop returns a value depending on all its results
+//so that the compiler cannot drop the calls
+typedef unsigned long long BenchFn(const Inputs *in);
+
+static unsigned long long
+bench_binary_to_bcd(const Inputs *in)
+{
+  unsigned long long sink = 0;
+  for (size_t i = 0; i < in->n; i++) {
+    BcdError err = OK_ERR;
+    sink += binary_to_bcd(in->binary[i], &err) + err;
+  }
+  return sink;
+}
+
+static unsigned long long
+bench_bcd_to_binary(const Inputs *in)
+{
+  unsigned long long sink = 0;
+  for (size_t i = 0; i < in->n; i++) {
+    BcdError err = OK_ERR;
+    sink += bcd_to_binary(in->x[i], &err) + err;
+  }
+  return sink;
+}
+
+static unsigned long long
+bench_str_to_bcd(const Inputs *in)
+{
+  unsigned long long sink = 0;
+  for (size_t i = 0; i < in->n; i++) {
+    BcdError err = OK_ERR;
+    const char *p;
+    sink += str_to_bcd(in->str[i], &p, &err) + err + *p;
+  }
+  return sink;
+}
+
+static unsigned long long
+bench_bcd_to_str(const Inputs *in)
+{
+  unsigned long long sink = 0;
+  for (size_t i = 0; i < in->n; i++) {
+    BcdError err = OK_ERR;
+    char buf[BCD_BUF_SIZE];
+    sink += bcd_to_str(in->x[i], buf, sizeof(buf), &err) + err + buf[0];
+  }
+  return sink;
+}
+
+static unsigned long long
+bench_bcd_add(const Inputs *in)
+{
+  unsigned long long sink = 0;
+  for (size_t i = 0; i < in->n; i++) {
+    BcdError err = OK_ERR;
+    sink += bcd_add(in->x[i], in->y[i], &err) + err;
+  }
+  return sink;
+}
+
+static unsigned long long
+bench_bcd_multiply(const Inputs *in)
+{
+  unsigned long long sink = 0;
+  for (size_t i = 0; i < in->n; i++) {
+    BcdError err = OK_ERR;
+    sink += bcd_multiply(in->x[i], in->y[i], &err) + err;
+  }
+  return sink;
+}
+
+static const struct {
+  const char *name;
+  BenchFn *fn;
+} BENCHES[] = {
+  { "binary_to_bcd", bench_binary_to_bcd },
+  { "bcd_to_binary", bench_bcd_to_binary },
+  { "str_to_bcd", bench_str_to_bcd },
+  { "bcd_to_str", bench_bcd_to_str },
+  { "bcd_add", bench_bcd_add },
+  { "bcd_multiply", bench_bcd_multiply },
+};
+#define N_BENCHES (sizeof(BENCHES)/sizeof(BENCHES[0]))
+
+static double
+now_secs(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1e9;
+}
+
+/** Return the two-sided 95% Student t quantile for df degrees of
+ *  freedom.
+ */
+static double
+t95(int df)
+{
+  static const double T95[] = {
+    0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+    2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+    2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045,
+    2.042,
+  };
+  enum { N_T95 = sizeof(T95)/sizeof(T95[0]) };
+  return (df < N_T95) ? T95[df] : 1.96;
+}
+
+typedef struct {
+  double mean;       //ns/op
+  double halfWidth;  //of 95% confidence interval for mean
+} Stats;
+
+/** Time fn over in nSamples times; return stats of ns/op. */
+static Stats
+time_bench(BenchFn *fn, const Inputs *in, int nSamples,
+           unsigned long long *sink)
+{
+  *sink += fn(in);  //warmup
+  double sum = 0, sumSq = 0;
+  for (int s = 0; s < nSamples; s++) {
+    double t0 = now_secs();
+    *sink += fn(in);
+    double nsPerOp = (now_secs() - t0) * 1e9 / in->n;
+    sum += nsPerOp;
+    sumSq += nsPerOp * nsPerOp;
+  }
+  Stats stats = { sum / nSamples, 0 };
+  if (nSamples > 1) {
+    double var = (sumSq - sum*sum/nSamples) / (nSamples - 1);
+    stats.halfWidth = t95(nSamples - 1) * sqrt(var > 0 ? var : 0) /
+      sqrt(nSamples);
+  }
+  return stats;
+}
+
+static void
+report(int isJson, const char *op, const char *input, Stats stats,
+       size_t nOps, int nSamples)
+{
+  if (isJson) {
+    printf("{\"bcd_base\": %d, \"bcd_bytes\": %zu, \"op\": \"%s\", "
+           "\"input\": \"%s\", \"ns_per_op\": %.4f, \"ci95_lo\": %.4f, "
+           "\"ci95_hi\": %.4f, \"n_ops\": %zu, \"n_samples\": %d}\n",
+           BCD_BASE, sizeof(Bcd), op, input, stats.mean,
+           stats.mean - stats.halfWidth, stats.mean + stats.halfWidth,
+           nOps, nSamples);
+  }
+  else {
+    printf("BCD_BASE=%d %-14s %-7s %9.3f ns/op  +/- %.3f (95%% CI)\n",
+           BCD_BASE, op, input, stats.mean, stats.halfWidth);
+  }
+}
+
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-j] [-n N_OPS] [-r N_SAMPLES] [-s SEED]\n",
+          prog);
+  exit(1);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  size_t nOps = DEFAULT_N_OPS;
+  int nSamples = DEFAULT_N_SAMPLES;
+  int isJson = 0;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  for (int i = 1; i < argc; i++) {
+    char *end;
+    if (strcmp(argv[i], "-j") == 0) {
+      isJson = 1;
+      continue;
+    }
+    if (i + 1 >= argc) usage(argv[0]);
+    if (strcmp(argv[i], "-n") == 0) {
+      long long n = strtoll(argv[++i], &end, 10);
+      if (*end != '\0' || n <= 0) usage(argv[0]);
+      nOps = n;
+    }
+    else if (strcmp(argv[i], "-r") == 0) {
+      long n = strtol(argv[++i], &end, 10);
+      if (*end != '\0' || n <= 0) usage(argv[0]);
+      nSamples = n;
+    }
+    else if (strcmp(argv[i], "-s") == 0) {
+      seed = strtoull(argv[++i], &end, 0);
+      if (*end != '\0' || seed == 0) usage(argv[0]);
+    }
+    else {
+      usage(argv[0]);
+    }
+  }
+
+  Inputs random, nines;
+  make_inputs(&random, nOps, MAX_BCD_DIGITS, &seed);
+  make_inputs(&nines, nOps, MAX_BCD_DIGITS, NULL);
+  unsigned long long sink = 0;
+  for (size_t b = 0; b < N_BENCHES; b++) {
+    Inputs *in = &random;
+    Inputs halfDigits;
+    if (BENCHES[b].fn == bench_bcd_multiply) {
+      make_inputs(&halfDigits, nOps, MAX_BCD_DIGITS/2, &seed);
+      in = &halfDigits;
+    }
+    report(isJson, BENCHES[b].name, "random",
+           time_bench(BENCHES[b].fn, in, nSamples, &sink), nOps, nSamples);
+    report(isJson, BENCHES[b].name, "nines",
+           time_bench(BENCHES[b].fn, &nines, nSamples, &sink), nOps,
+           nSamples);
+    if (in == &halfDigits) free_inputs(&halfDigits);
+  }
+  free_inputs(&random); free_inputs(&nines);
+
+  //make sink observable
+  if (sink == 42) fprintf(stderr, "\n");
+  return 0;
+}
@@ -0,0 +1,272 @@
+#include "bcdbig.h"
+
+#include <check.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { ARENA_BLOCK_SIZE = 1 << 16 };
+
+static BcdArena *ARENA;
+
+static void
+setup(void)
+{
+  ARENA = bcd_arena_new(ARENA_BLOCK_SIZE);
+}
+
+static void
+teardown(void)
+{
+  bcd_arena_free(ARENA);
+}
+
+static BcdBig
+big(const char *s)
+{
+  const char *p;
+  BcdBig x = str_to_bcdbig(s, &p, ARENA);
+  ck_assert_int_eq(*p, '\0');
+  return x;
+}
+
+/** Return string for x allocated in ARENA. */
+static const char *
+str(BcdBig x)
+{
+  size_t size = bcdbig_str_size(x);
+  char *buf = bcd_arena_alloc(ARENA, size);
+  BcdError err = OK_ERR;
+  int n = bcdbig_to_str(x, buf, size, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_int_eq(n, size - 1);
+  return buf;
+}
+
+/** Return prefix followed by n copies of c followed by suffix,
+ *  allocated in ARENA.
+ */
+static char *
+digits(const char *prefix, char c, size_t n, const char *suffix)
+{
+  size_t nPrefix = strlen(prefix);
+  char *s = bcd_arena_alloc(ARENA, nPrefix + n + strlen(suffix) + 1);
+  strcpy(s, prefix);
+  memset(s + nPrefix, c, n);
+  strcpy(s + nPrefix + n, suffix);
+  return s;
+}
+
+/*************************** String Conversion *************************/
+
+START_TEST(bcdbig_str_roundtrip)
+{
+  const char *s = "1234567890123456789012345678901234567890";
+  ck_assert_str_eq(str(big(s)), s);
+  ck_assert_str_eq(str(big("0")), "0");
+  ck_assert_str_eq(str(big("000000000000000000000042")), "42");
+}
+END_TEST
+
+START_TEST(bcdbig_str_not_nul_terminator)
+{
+  const char *p;
+  BcdBig x = str_to_bcdbig("98765432109876543210x", &p, ARENA);
+  ck_assert_int_eq(*p, 'x');
+  ck_assert_str_eq(str(x), "98765432109876543210");
+}
+END_TEST
+
+START_TEST(bcdbig_str_overflow)
+{
+  BcdBig x = big("12345678901234567890");
+  char buf[20];
+  BcdError err = OK_ERR;
+  bcdbig_to_str(x, buf, sizeof(buf), &err);
+  ck_assert_int_eq(err, OVERFLOW_ERR);
+}
+END_TEST
+
+START_TEST(bcdbig_str_bad_value)
+{
+  BcdLimb limbs[] = { 0x123a };
+  BcdBig x = { 1, limbs };
+  char buf[32];
+  BcdError err = OK_ERR;
+  bcdbig_to_str(x, buf, sizeof(buf), &err);
+  ck_assert_int_eq(err, BAD_VALUE_ERR);
+}
+END_TEST
+
+/************************** Add, Subtract, Compare *********************/
+
+START_TEST(bcdbig_add_carry)
+{
+  BcdError err = OK_ERR;
+  BcdBig sum = bcdbig_add(big(digits("", '9', 40, "")), big("1"),
+                          ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_str_eq(str(sum), digits("1", '0', 40, ""));
+}
+END_TEST
+
+START_TEST(bcdbig_subtract_borrow)
+{
+  BcdError err = OK_ERR;
+  BcdBig diff = bcdbig_subtract(big(digits("1", '0', 40, "")), big("1"),
+                                ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_str_eq(str(diff), digits("", '9', 40, ""));
+
+  diff = bcdbig_subtract(big(digits("1", '0', 39, "5")), big("7"),
+                         ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_str_eq(str(diff), digits("", '9', 39, "8"));
+
+  diff = bcdbig_subtract(big("12345678901234567890"),
+                         big("12345678901234567890"), ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_str_eq(str(diff), "0");
+}
+END_TEST
+
+START_TEST(bcdbig_subtract_negative)
+{
+  BcdError err = OK_ERR;
+  bcdbig_subtract(big("1"), big("12345678901234567890"), ARENA, &err);
+  ck_assert_int_eq(err, OVERFLOW_ERR);
+}
+END_TEST
+
+START_TEST(bcdbig_compare_values)
+{
+  ck_assert_int_lt(bcdbig_compare(big("9"), big("12345678901234567890")), 0);
+  ck_assert_int_gt(bcdbig_compare(big("12345678901234567891"),
+                                  big("12345678901234567890")), 0);
+  ck_assert_int_eq(bcdbig_compare(big("00012345678901234567890"),
+                                  big("12345678901234567890")), 0);
+}
+END_TEST
+
+/****************************** Multiply *******************************/
+
+START_TEST(bcdbig_multiply_small)
+{
+  BcdError err = OK_ERR;
+  BcdBig product = bcdbig_multiply(big("12345678901234567890"),
+                                   big("98765432109876543210"),
+                                   ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_str_eq(str(product),
+                   "1219326311370217952237463801111263526900");
+}
+END_TEST
+
+START_TEST(bcdbig_multiply_zero)
+{
+  BcdError err = OK_ERR;
+  BcdBig product = bcdbig_multiply(big("0"), big(digits("", '7', 500, "")),
+                                   ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  ck_assert_str_eq(str(product), "0");
+}
+END_TEST
+
+/** (10**n - 1)**2 == 9...9 8 0...0 1 with n - 1 9's and 0's. */
+static void
+check_nines_squared(size_t n)
+{
+  BcdBig nines = big(digits("", '9', n, ""));
+  BcdError err = OK_ERR;
+  BcdBig product = bcdbig_multiply(nines, nines, ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  char *expected = bcd_arena_alloc(ARENA, 2*n + 1);
+  memset(expected, '9', n - 1);
+  expected[n - 1] = '8';
+  memset(expected + n, '0', n - 1);
+  strcpy(expected + 2*n - 1, "1");
+  ck_assert_str_eq(str(product), expected);
+}
+
+START_TEST(bcdbig_multiply_karatsuba)
+{
+  //sizes on both sides of the Karatsuba threshold
+  check_nines_squared(100);
+  check_nines_squared(1000);
+  check_nines_squared(3001);
+}
+END_TEST
+
+START_TEST(bcdbig_multiply_unbalanced)
+{
+  //(10**2000 - 1) * (10**300 - 1) == 10**2300 - 10**2000 - 10**300 + 1
+  BcdError err = OK_ERR;
+  BcdBig product = bcdbig_multiply(big(digits("", '9', 2000, "")),
+                                   big(digits("", '9', 300, "")),
+                                   ARENA, &err);
+  ck_assert_int_eq(err, OK_ERR);
+  char *expected = bcd_arena_alloc(ARENA, 2301);
+  memset(expected, '9', 299);
+  expected[299] = '8';
+  memset(expected + 300, '9', 1700);
+  memset(expected + 2000, '0', 299);
+  strcpy(expected + 2299, "1");
+  ck_assert_str_eq(str(product), expected);
+}
+END_TEST
+
+START_TEST(bcdbig_multiply_bad_value)
+{
+  BcdLimb limbs[] = { 0xf };
+  BcdBig bad = { 1, limbs };
+  BcdError err = OK_ERR;
+  bcdbig_multiply(big("12"), bad, ARENA, &err);
+  ck_assert_int_eq(err, BAD_VALUE_ERR);
+}
+END_TEST
+
+/*********************** Test Suite and Runner *************************/
+
+static Suite *
+bcdbig_suite(void)
+{
+  Suite *suite = suite_create("bcdbig");
+
+  TCase *strConv = tcase_create("bcdbig_str");
+  tcase_add_checked_fixture(strConv, setup, teardown);
+  tcase_add_test(strConv, bcdbig_str_roundtrip);
+  tcase_add_test(strConv, bcdbig_str_not_nul_terminator);
+  tcase_add_test(strConv, bcdbig_str_overflow);
+  tcase_add_test(strConv, bcdbig_str_bad_value);
+  suite_add_tcase(suite, strConv);
+
+  TCase *addSub = tcase_create("bcdbig_add_subtract");
+  tcase_add_checked_fixture(addSub, setup, teardown);
+  tcase_add_test(addSub, bcdbig_add_carry);
+  tcase_add_test(addSub, bcdbig_subtract_borrow);
+  tcase_add_test(addSub, bcdbig_subtract_negative);
+  tcase_add_test(addSub, bcdbig_compare_values);
+  suite_add_tcase(suite, addSub);
+
+  TCase *multiply = tcase_create("bcdbig_multiply");
+  tcase_add_checked_fixture(multiply, setup, teardown);
+  tcase_add_test(multiply, bcdbig_multiply_small);
+  tcase_add_test(multiply, bcdbig_multiply_zero);
+  tcase_add_test(multiply, bcdbig_multiply_karatsuba);
+  tcase_add_test(multiply, bcdbig_multiply_unbalanced);
+  tcase_add_test(multiply, bcdbig_multiply_bad_value);
+  suite_add_tcase(suite, multiply);
+
+  return suite;
+}
+
+int
+main(void)
+{
+  SRunner *runner = srunner_create(bcdbig_suite());
+  srunner_run_all(runner, CK_NORMAL);
+  int nFail = srunner_ntests_failed(runner);
+  srunner_free(runner);
+  return nFail != 0;
+}
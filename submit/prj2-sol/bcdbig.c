@@ -0,0 +1,485 @@
+#include "bcdbig.h"
+#include "bcdkernels.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************* Arena *********************************/
+
+enum { ARENA_ALIGN = 16 };
+
+typedef struct ArenaBlock {
+  struct ArenaBlock *next;
+  size_t size;                  //# of bytes available in data[]
+  size_t used;                  //# of bytes of data[] allocated
+  _Alignas(ARENA_ALIGN) unsigned char data[];
+} ArenaBlock;
+
+struct BcdArena {
+  size_t blockSize;
+  ArenaBlock *head;
+  ArenaBlock *current;          //block currently being allocated from
+};
+
+/** Position in an arena: allocations made after taking a mark can be
+ *  released by arena_release() without affecting earlier ones.
+ */
+typedef struct {
+  ArenaBlock *block;
+  size_t used;
+} ArenaMark;
+
+static ArenaBlock *
+new_arena_block(size_t size)
+{
+  ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+  if (!block) {
+    fprintf(stderr, "could not malloc arena block: %s\n", strerror(errno));
+    exit(1);
+  }
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+BcdArena *
+bcd_arena_new(size_t blockSize)
+{
+  BcdArena *arena = malloc(sizeof(BcdArena));
+  if (!arena) {
+    fprintf(stderr, "could not malloc arena: %s\n", strerror(errno));
+    exit(1);
+  }
+  arena->blockSize = blockSize;
+  arena->head = arena->current = new_arena_block(blockSize);
+  return arena;
+}
+
+void *
+bcd_arena_alloc(BcdArena *arena, size_t size)
+{
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  ArenaBlock *block = arena->current;
+  while (block->size - block->used < size) {
+    if (!block->next || block->next->size < size) {
+      size_t blockSize = (size > arena->blockSize) ? size : arena->blockSize;
+      ArenaBlock *fresh = new_arena_block(blockSize);
+      fresh->next = block->next;
+      block->next = fresh;
+    }
+    block = block->next;
+    block->used = 0;
+  }
+  arena->current = block;
+  void *p = &block->data[block->used];
+  block->used += size;
+  return p;
+}
+
+void
+bcd_arena_reset(BcdArena *arena)
+{
+  arena->current = arena->head;
+  arena->head->used = 0;
+}
+
+void
+bcd_arena_free(BcdArena *arena)
+{
+  if (!arena) return;
+  for (ArenaBlock *p = arena->head, *next; p != NULL; p = next) {
+    next = p->next;
+    free(p);
+  }
+  free(arena);
+}
+
+static inline ArenaMark
+arena_mark(const BcdArena *arena)
+{
+  return (ArenaMark) { arena->current, arena->current->used };
+}
+
+static inline void
+arena_release(BcdArena *arena, ArenaMark mark)
+{
+  arena->current = mark.block;
+  mark.block->used = mark.used;
+}
+
+/************************** Limb Utilities *****************************/
+
+static const BcdBig ZERO = { 0, NULL };
+
+static inline BcdBig
+normalize(BcdBig x)
+{
+  while (x.nLimbs > 0 && x.limbs[x.nLimbs - 1] == 0) x.nLimbs--;
+  return x;
+}
+
+static inline int
+has_bad_digits(BcdBig x)
+{
+  BcdWide bad = 0;
+  for (size_t i = 0; i < x.nLimbs; i++) bad |= bad_digits(x.limbs[i]);
+  return bad != 0;
+}
+
+/** Return # of significant digits in limb != 0. */
+static inline int
+limb_n_digits(BcdLimb limb)
+{
+  return BCD_LIMB_DIGITS - __builtin_clzll(limb)/BCD_BITS;
+}
+
+/******************************** Strings ******************************/
+
+/** Return # of leading decimal digits in s. */
+static size_t
+count_digits(const char *s)
+{
+  size_t n = 0;
+  for (;;) {
+#ifdef __SSE2__
+    if (can_load16(s + n)) {
+      BcdWide packed;
+      int k = pack16_digits(s + n, &packed);
+      n += k;
+      if (k < ASCII_VEC_SIZE) return n;
+      continue;
+    }
+#endif
+    if (s[n] < '0' || s[n] > '9') return n;
+    n++;
+  }
+}
+
+/** Return the len <= BCD_LIMB_DIGITS decimal digits at s as a limb. */
+static BcdLimb
+pack_limb(const char *s, int len)
+{
+#ifdef __SSE2__
+  if (can_load16(s)) {
+    BcdWide packed;
+    int n = pack16_digits(s, &packed);  //n >= len
+    return packed >> (BCD_BITS * (n - len));
+  }
+#endif
+  BcdLimb limb = 0;
+  for (int i = 0; i < len; i++) limb = (limb << BCD_BITS) | (s[i] - '0');
+  return limb;
+}
+
+BcdBig
+str_to_bcdbig(const char *s, const char **p, BcdArena *arena)
+{
+  size_t nDigits = count_digits(s);
+  *p = s + nDigits;
+  BcdBig x;
+  x.nLimbs = (nDigits + BCD_LIMB_DIGITS - 1) / BCD_LIMB_DIGITS;
+  x.limbs = bcd_arena_alloc(arena, x.nLimbs * sizeof(BcdLimb));
+  //most significant limb may be partial
+  int len = nDigits - (x.nLimbs - 1) * BCD_LIMB_DIGITS;
+  for (size_t i = x.nLimbs; i > 0; i--) {
+    x.limbs[i - 1] = pack_limb(s, len);
+    s += len;
+    len = BCD_LIMB_DIGITS;
+  }
+  return normalize(x);
+}
+
+size_t
+bcdbig_str_size(BcdBig x)
+{
+  if (x.nLimbs == 0) return 2;
+  return (x.nLimbs - 1) * BCD_LIMB_DIGITS +
+    limb_n_digits(x.limbs[x.nLimbs - 1]) + 1;
+}
+
+int
+bcdbig_to_str(BcdBig x, char buf[], size_t bufSize, BcdError *error)
+{
+  size_t size = bcdbig_str_size(x);
+  if (bufSize < size) {
+    if (error) *error = OVERFLOW_ERR;
+    return 0;
+  }
+  if (has_bad_digits(x)) {
+    if (error) *error = BAD_VALUE_ERR;
+    return 0;
+  }
+  if (x.nLimbs == 0) {
+    strcpy(buf, "0");
+    return 1;
+  }
+  char digits[ASCII_VEC_SIZE];
+  BcdLimb top = x.limbs[x.nLimbs - 1];
+  int nTop = limb_n_digits(top);
+  unpack16_digits(top, digits);
+  memcpy(buf, &digits[ASCII_VEC_SIZE - nTop], nTop);
+  char *q = buf + nTop;
+  for (size_t i = x.nLimbs - 1; i > 0; i--) {
+    unpack16_digits(x.limbs[i - 1], digits);
+    memcpy(q, digits, BCD_LIMB_DIGITS);
+    q += BCD_LIMB_DIGITS;
+  }
+  *q = '\0';
+  return q - buf;
+}
+
+/************************** Add, Subtract, Compare *********************/
+
+int
+bcdbig_compare(BcdBig x, BcdBig y)
+{
+  if (x.nLimbs != y.nLimbs) return (x.nLimbs < y.nLimbs) ? -1 : 1;
+  //packed BCD limbs with valid digits order the same as their values
+  for (size_t i = x.nLimbs; i > 0; i--) {
+    if (x.limbs[i - 1] != y.limbs[i - 1]) {
+      return (x.limbs[i - 1] < y.limbs[i - 1]) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+BcdBig
+bcdbig_add(BcdBig x, BcdBig y, BcdArena *arena, BcdError *error)
+{
+  if (has_bad_digits(x) || has_bad_digits(y)) {
+    if (error) *error = BAD_VALUE_ERR;
+    return ZERO;
+  }
+  if (x.nLimbs < y.nLimbs) { BcdBig t = x; x = y; y = t; }
+  BcdBig z;
+  z.limbs = bcd_arena_alloc(arena, (x.nLimbs + 1) * sizeof(BcdLimb));
+  BcdWide carry = 0;
+  for (size_t i = 0; i < x.nLimbs; i++) {
+    BcdLimb yi = (i < y.nLimbs) ? y.limbs[i] : 0;
+    z.limbs[i] = bcd_wide_add(x.limbs[i], yi, carry, &carry);
+  }
+  z.limbs[x.nLimbs] = carry;
+  z.nLimbs = x.nLimbs + 1;
+  return normalize(z);
+}
+
+BcdBig
+bcdbig_subtract(BcdBig x, BcdBig y, BcdArena *arena, BcdError *error)
+{
+  if (has_bad_digits(x) || has_bad_digits(y)) {
+    if (error) *error = BAD_VALUE_ERR;
+    return ZERO;
+  }
+  if (bcdbig_compare(x, y) < 0) {
+    if (error) *error = OVERFLOW_ERR;
+    return ZERO;
+  }
+  //x - y == x + (10's complement of y) - 10**(# of digits in x)
+  const BcdLimb NINES = 0x9999999999999999ULL;
+  BcdBig z;
+  z.nLimbs = x.nLimbs;
+  z.limbs = bcd_arena_alloc(arena, x.nLimbs * sizeof(BcdLimb));
+  BcdWide carry = 1;
+  for (size_t i = 0; i < x.nLimbs; i++) {
+    BcdLimb yi = (i < y.nLimbs) ? y.limbs[i] : 0;
+    z.limbs[i] = bcd_wide_add(x.limbs[i], NINES - yi, carry, &carry);
+  }
+  return normalize(z);
+}
+
+/***************************** Multiply ********************************/
+
+//Multiplication works on radix-10**8 digits, each obtained from half
+//a limb, since products of those fit comfortably in 64 bits.
+typedef uint32_t RadixDigit;
+
+enum {
+  RADIX = 100000000,
+  RADIX_DIGITS_PER_LIMB = 2,
+
+  //operands with fewer radix digits than this use schoolbook
+  //multiplication; tuned on x86-64 for 1000 to 50000 digit operands
+  KARATSUBA_THRESHOLD = 48,
+};
+
+/** Return binary value of 8 packed BCD digits. */
+static inline RadixDigit
+bcd8_to_radix(uint32_t bcd)
+{
+  uint64_t x = bcd;
+  x = (x & 0x0F0F0F0F) + ((x >> 4) & 0x0F0F0F0F)*10;
+  x = (x & 0x00FF00FF) + ((x >> 8) & 0x00FF00FF)*100;
+  return (x & 0xFFFF) + (x >> 16)*10000;
+}
+
+/** Return 8 packed BCD digits for d < RADIX. */
+static inline uint32_t
+radix_to_bcd8(RadixDigit d)
+{
+  unsigned hi = d / 10000;
+  return (bcd4(hi) << 16) | bcd4(d - hi*10000);
+}
+
+/** r[0, n) += a[0, na) where na <= n.  Returns carry out. */
+static RadixDigit
+radix_add(RadixDigit r[], size_t n, const RadixDigit a[], size_t na)
+{
+  RadixDigit carry = 0;
+  size_t i;
+  for (i = 0; i < na; i++) {
+    RadixDigit t = r[i] + a[i] + carry;
+    carry = t >= RADIX;
+    r[i] = t - carry*RADIX;
+  }
+  for (; carry && i < n; i++) {
+    RadixDigit t = r[i] + carry;
+    carry = t >= RADIX;
+    r[i] = t - carry*RADIX;
+  }
+  return carry;
+}
+
+/** r[0, n) -= a[0, na) where na <= n and r >= a. */
+static void
+radix_sub(RadixDigit r[], size_t n, const RadixDigit a[], size_t na)
+{
+  RadixDigit borrow = 0;
+  size_t i;
+  for (i = 0; i < na; i++) {
+    RadixDigit sub = a[i] + borrow;
+    borrow = r[i] < sub;
+    r[i] = r[i] + borrow*RADIX - sub;
+  }
+  for (; borrow && i < n; i++) {
+    borrow = r[i] == 0;
+    r[i] = r[i] + borrow*RADIX - 1;
+  }
+}
+
+/** Set r[0, na + nb) to a[0, na) * b[0, nb). */
+static void
+school_multiply(const RadixDigit a[], size_t na,
+                const RadixDigit b[], size_t nb, RadixDigit r[])
+{
+  memset(r, 0, (na + nb) * sizeof(RadixDigit));
+  for (size_t i = 0; i < na; i++) {
+    uint64_t ai = a[i];
+    uint64_t carry = 0;
+    for (size_t j = 0; j < nb; j++) {
+      uint64_t t = r[i + j] + ai*b[j] + carry;
+      carry = t / RADIX;
+      r[i + j] = t - carry*RADIX;
+    }
+    r[i + nb] = carry;
+  }
+}
+
+/** Set r[0, 2n) to a[0, n) * b[0, n) using Karatsuba's method, with
+ *  temporaries from arena.
+ */
+static void
+karatsuba_multiply(const RadixDigit a[], const RadixDigit b[], size_t n,
+                   RadixDigit r[], BcdArena *arena)
+{
+  if (n < KARATSUBA_THRESHOLD) {
+    school_multiply(a, n, b, n, r);
+    return;
+  }
+  //a = a1*R**h + a0, b = b1*R**h + b0
+  size_t h = n/2, m = n - h;
+  karatsuba_multiply(a, b, h, r, arena);                 //a0*b0
+  karatsuba_multiply(a + h, b + h, m, r + 2*h, arena);   //a1*b1
+
+  ArenaMark mark = arena_mark(arena);
+  RadixDigit *sa = bcd_arena_alloc(arena, (m + 1)*sizeof(RadixDigit));
+  RadixDigit *sb = bcd_arena_alloc(arena, (m + 1)*sizeof(RadixDigit));
+  RadixDigit *t = bcd_arena_alloc(arena, 2*(m + 1)*sizeof(RadixDigit));
+  memcpy(sa, a + h, m*sizeof(RadixDigit)); sa[m] = 0;
+  memcpy(sb, b + h, m*sizeof(RadixDigit)); sb[m] = 0;
+  radix_add(sa, m + 1, a, h);
+  radix_add(sb, m + 1, b, h);
+
+  //t = (a0 + a1)*(b0 + b1) - a0*b0 - a1*b1 = a0*b1 + a1*b0
+  karatsuba_multiply(sa, sb, m + 1, t, arena);
+  radix_sub(t, 2*(m + 1), r, 2*h);
+  radix_sub(t, 2*(m + 1), r + 2*h, 2*m);
+
+  //t < R**(n + 1), so its top digits beyond r[2n) are zero
+  size_t nt = 2*(m + 1);
+  while (nt > 0 && t[nt - 1] == 0) nt--;
+  radix_add(r + h, 2*n - h, t, nt);
+  arena_release(arena, mark);
+}
+
+/** Set r[0, na + nb) to a[0, na) * b[0, nb). */
+static void
+radix_multiply(const RadixDigit a[], size_t na,
+               const RadixDigit b[], size_t nb,
+               RadixDigit r[], BcdArena *arena)
+{
+  if (na < nb) {
+    const RadixDigit *t = a; a = b; b = t;
+    size_t nt = na; na = nb; nb = nt;
+  }
+  if (nb < KARATSUBA_THRESHOLD) {
+    school_multiply(a, na, b, nb, r);
+    return;
+  }
+  //multiply nb-digit chunks of the longer operand by b and accumulate
+  memset(r, 0, (na + nb)*sizeof(RadixDigit));
+  ArenaMark mark = arena_mark(arena);
+  RadixDigit *chunk = bcd_arena_alloc(arena, nb*sizeof(RadixDigit));
+  RadixDigit *product = bcd_arena_alloc(arena, 2*nb*sizeof(RadixDigit));
+  for (size_t i = 0; i < na; i += nb) {
+    size_t n = (na - i < nb) ? na - i : nb;
+    memcpy(chunk, a + i, n*sizeof(RadixDigit));
+    memset(chunk + n, 0, (nb - n)*sizeof(RadixDigit));
+    karatsuba_multiply(chunk, b, nb, product, arena);
+    radix_add(r + i, na + nb - i, product, n + nb);
+  }
+  arena_release(arena, mark);
+}
+
+/** Return x converted to radix digits, allocated in arena. */
+static RadixDigit *
+to_radix(BcdBig x, BcdArena *arena)
+{
+  RadixDigit *d =
+    bcd_arena_alloc(arena, x.nLimbs*RADIX_DIGITS_PER_LIMB*sizeof(RadixDigit));
+  for (size_t i = 0; i < x.nLimbs; i++) {
+    d[2*i] = bcd8_to_radix(x.limbs[i] & 0xFFFFFFFF);
+    d[2*i + 1] = bcd8_to_radix(x.limbs[i] >> 32);
+  }
+  return d;
+}
+
+BcdBig
+bcdbig_multiply(BcdBig x, BcdBig y, BcdArena *arena, BcdError *error)
+{
+  if (has_bad_digits(x) || has_bad_digits(y)) {
+    if (error) *error = BAD_VALUE_ERR;
+    return ZERO;
+  }
+  if (x.nLimbs == 0 || y.nLimbs == 0) return ZERO;
+  BcdBig z;
+  z.nLimbs = x.nLimbs + y.nLimbs;
+  z.limbs = bcd_arena_alloc(arena, z.nLimbs*sizeof(BcdLimb));
+
+  ArenaMark mark = arena_mark(arena);
+  size_t na = x.nLimbs*RADIX_DIGITS_PER_LIMB;
+  size_t nb = y.nLimbs*RADIX_DIGITS_PER_LIMB;
+  RadixDigit *a = to_radix(x, arena);
+  RadixDigit *b = to_radix(y, arena);
+  RadixDigit *r = bcd_arena_alloc(arena, (na + nb)*sizeof(RadixDigit));
+  radix_multiply(a, na, b, nb, r, arena);
+  for (size_t i = 0; i < z.nLimbs; i++) {
+    z.limbs[i] = ((BcdLimb)radix_to_bcd8(r[2*i + 1]) << 32) |
+      radix_to_bcd8(r[2*i]);
+  }
+  arena_release(arena, mark);
+  return normalize(z);
+}
@@ -0,0 +1,103 @@
+#ifndef BCDBIG_H_
+#define BCDBIG_H_
+
+#include "bcd.h"
+
+#include <stddef.h>
+
+/** An arena from which all BcdBig's and their temporaries are
+ *  allocated.  Individual allocations are never freed; instead the
+ *  whole arena is reset or freed at once.
+ */
+typedef struct BcdArena BcdArena;
+
+/** Return a new arena which allocates from blocks of (at least)
+ *  blockSize bytes.  Exits the program if memory is exhausted.
+ */
+BcdArena *bcd_arena_new(size_t blockSize);
+
+/** Return size bytes aligned for any BcdBig use from arena.  Exits
+ *  the program if memory is exhausted.
+ */
+void *bcd_arena_alloc(BcdArena *arena, size_t size);
+
+/** Release all allocations made from arena, retaining its memory for
+ *  reuse.
+ */
+void bcd_arena_reset(BcdArena *arena);
+
+/** Free arena and all memory allocated from it. */
+void bcd_arena_free(BcdArena *arena);
+
+
+//a limb contains BCD_LIMB_DIGITS packed BCD digits
+typedef unsigned long long BcdLimb;
+
+enum {
+  BCD_LIMB_DIGITS = sizeof(BcdLimb) * CHAR_BIT / BCD_BITS
+};
+
+/** An arbitrary-precision unsigned BCD number.  Its value is
+ *  sum(limbs[i] * 10**(BCD_LIMB_DIGITS*i)) for i in [0, nLimbs).
+ *  Always normalized: limbs[nLimbs - 1] != 0, so zero has nLimbs == 0.
+ */
+typedef struct {
+  size_t nLimbs;
+  BcdLimb *limbs;
+} BcdBig;
+
+/** Return BcdBig for the decimal number corresponding to the leading
+ *  digits of string s, allocated in arena.  Sets *p to point to first
+ *  non-digit char in s.  Roughly equivalent to str_to_bcd() but
+ *  without any limit on the number of digits.
+ */
+BcdBig str_to_bcdbig(const char *s, const char **p, BcdArena *arena);
+
+/** Return the size of the buffer (including '\0') needed to hold the
+ *  string representation of x.
+ */
+size_t bcdbig_str_size(BcdBig x);
+
+/** Convert x to a NUL-terminated string in buf[] without any
+ *  non-significant leading zeros.  Never write more than bufSize
+ *  characters into buf.  The return value is the number of characters
+ *  written (excluding the terminating NUL).
+ *
+ *  If error is not NULL, sets *error to BAD_VALUE_ERR if x contains a
+ *  BCD digit which is greater than 9, OVERFLOW_ERR if bufSize is less
+ *  than bcdbig_str_size(x), otherwise *error is unchanged.
+ */
+int bcdbig_to_str(BcdBig x, char buf[], size_t bufSize, BcdError *error);
+
+/** Return < 0, 0, > 0 when x is <, ==, > y. */
+int bcdbig_compare(BcdBig x, BcdBig y);
+
+/** Return x + y allocated in arena.
+ *
+ *  If error is not NULL, sets *error to BAD_VALUE_ERR if x or y
+ *  contains a BCD digit which is greater than 9, otherwise *error is
+ *  unchanged.
+ */
+BcdBig bcdbig_add(BcdBig x, BcdBig y, BcdArena *arena, BcdError *error);
+
+/** Return x - y allocated in arena.
+ *
+ *  If error is not NULL, sets *error to BAD_VALUE_ERR if x or y
+ *  contains a BCD digit which is greater than 9, OVERFLOW_ERR if
+ *  x < y (the result is not representable), otherwise *error is
+ *  unchanged.
+ */
+BcdBig bcdbig_subtract(BcdBig x, BcdBig y, BcdArena *arena,
+                       BcdError *error);
+
+/** Return x * y allocated in arena.  Uses schoolbook multiplication
+ *  for small operands and Karatsuba multiplication for large ones.
+ *
+ *  If error is not NULL, sets *error to BAD_VALUE_ERR if x or y
+ *  contains a BCD digit which is greater than 9, otherwise *error is
+ *  unchanged.
+ */
+BcdBig bcdbig_multiply(BcdBig x, BcdBig y, BcdArena *arena,
+                       BcdError *error);
+
+#endif //ifndef BCDBIG_H_
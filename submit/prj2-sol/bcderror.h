@@ -0,0 +1,18 @@
+#ifndef BCDERROR_H_
+#define BCDERROR_H_
+
+//error codes returned by the BCD API's; independent of BCD_BASE
+typedef enum {
+  OK_ERR,                  //no error
+  BAD_VALUE_ERR,           //binary BCD value contains a digit > 9
+  OVERFLOW_ERR             //an overflow was detected
+} BcdError;
+
+//per-element error bitmap filled in by the batch (bcd_*_n()) API's:
+//element i is in error iff bit i % 64 of word i / 64 is set
+typedef unsigned long long BcdErrorBits;
+
+//# of BcdErrorBits words needed for a bitmap of n elements
+#define BCD_ERROR_BITS_WORDS(n) (((n) + 63) / 64)
+
+#endif //ifndef BCDERROR_H_
@@ -0,0 +1,117 @@
+#include "bcdgeneric.h"
+
+#include <check.h>
+
+#include <string.h>
+
+/** Tests of libbcd.a through the bcd_*_any() macros of bcdgeneric.h:
+ *  the same checks for each width, each with variables of that width
+ *  only, so that every check goes through the _Generic dispatch to the
+ *  suffixed function for the width.
+ */
+
+//0x99...9 over the width of type T
+#define NINES(T) ((T)((T)~(T)0 / 0xf * 9))
+
+#define SCALAR_TEST(T, name) \
+START_TEST(name) \
+{ \
+  enum { N_DIGITS = sizeof(T) * 2 }; \
+  const T max = NINES(T); \
+  BcdError err = OK_ERR; \
+  \
+  /*the result has the width of the first Bcd argument*/ \
+  ck_assert_int_eq(sizeof(bcd_add_any(max, max, NULL)), sizeof(T)); \
+  \
+  char nines[N_DIGITS + 1]; \
+  memset(nines, '9', N_DIGITS); \
+  nines[N_DIGITS] = '\0'; \
+  T x = 0; \
+  const char *p; \
+  str_to_bcd_any(&x, nines, &p, &err); \
+  ck_assert(x == max); \
+  ck_assert_int_eq(*p, '\0'); \
+  ck_assert_int_eq(err, OK_ERR); \
+  \
+  char buf[N_DIGITS + 1]; \
+  ck_assert_int_eq(bcd_to_str_any(max, buf, sizeof(buf), &err), N_DIGITS); \
+  ck_assert_str_eq(buf, nines); \
+  ck_assert_int_eq(err, OK_ERR); \
+  \
+  ck_assert(binary_to_bcd_any((T)12, &err) == 0x12); \
+  ck_assert(bcd_to_binary_any((T)0x99, &err) == 99); \
+  ck_assert(bcd_add_any((T)0x19, (T)0x3, &err) == 0x22); \
+  ck_assert(bcd_multiply_any((T)0x12, (T)0x3, &err) == 0x36); \
+  ck_assert_int_eq(err, OK_ERR); \
+  bcd_add_any(max, (T)1, &err); \
+  ck_assert_int_eq(err, OVERFLOW_ERR); \
+} \
+END_TEST
+
+#define BATCH_TEST(T, name) \
+START_TEST(name) \
+{ \
+  const T xs[] = { 0x1, 0x19, NINES(T) }; \
+  const T ys[] = { 0x2, 0x3, 0x1 }; \
+  T zs[3]; \
+  BcdErrorBits errors[BCD_ERROR_BITS_WORDS(3)] = { 0 }; \
+  ck_assert_int_eq(bcd_add_n_any(xs, ys, zs, 3, errors), 1); \
+  ck_assert(zs[0] == 0x3 && zs[1] == 0x22 && zs[2] == 0); \
+  ck_assert(errors[0] == 0x4); \
+  \
+  errors[0] = 0; \
+  ck_assert_int_eq(bcd_mul_small_n_any(xs, 2, zs, 2, errors), 0); \
+  ck_assert(zs[0] == 0x2 && zs[1] == 0x38); \
+  \
+  BcdError err = OK_ERR; \
+  ck_assert(bcd_sum_reduce_any(xs, 2, errors, &err) == 0x20); \
+  ck_assert_int_eq(err, OK_ERR); \
+} \
+END_TEST
+
+SCALAR_TEST(unsigned char, generic_u8)
+SCALAR_TEST(unsigned short, generic_u16)
+SCALAR_TEST(unsigned, generic_u32)
+SCALAR_TEST(unsigned long, generic_ul)
+SCALAR_TEST(unsigned long long, generic_u64)
+
+//no unsigned long: bcdgeneric.h only takes arrays of the exact types
+BATCH_TEST(unsigned char, generic_n_u8)
+BATCH_TEST(unsigned short, generic_n_u16)
+BATCH_TEST(unsigned, generic_n_u32)
+BATCH_TEST(unsigned long long, generic_n_u64)
+
+/*********************** Test Suite and Runner *************************/
+
+static Suite *
+bcdgeneric_suite(void)
+{
+  Suite *suite = suite_create("bcdgeneric");
+
+  TCase *scalar = tcase_create("scalar");
+  tcase_add_test(scalar, generic_u8);
+  tcase_add_test(scalar, generic_u16);
+  tcase_add_test(scalar, generic_u32);
+  tcase_add_test(scalar, generic_ul);
+  tcase_add_test(scalar, generic_u64);
+  suite_add_tcase(suite, scalar);
+
+  TCase *batch = tcase_create("batch");
+  tcase_add_test(batch, generic_n_u8);
+  tcase_add_test(batch, generic_n_u16);
+  tcase_add_test(batch, generic_n_u32);
+  tcase_add_test(batch, generic_n_u64);
+  suite_add_tcase(suite, batch);
+
+  return suite;
+}
+
+int
+main(void)
+{
+  SRunner *runner = srunner_create(bcdgeneric_suite());
+  srunner_run_all(runner, CK_NORMAL);
+  int nFail = srunner_ntests_failed(runner);
+  srunner_free(runner);
+  return nFail != 0;
+}
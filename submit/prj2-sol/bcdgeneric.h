@@ -0,0 +1,100 @@
+#ifndef BCDGENERIC_H_
+#define BCDGENERIC_H_
+
+//Interface to libbcd.a, which contains the BCD API of bcd.h for every
+//width of Bcd at once.  Each width's functions have the same
+//semantics as the corresponding bcd.h function, with a suffix naming
+//the width: _u8, _u16, _u32 or _u64.  Since each is compiled with a
+//constant width, all masks and loop bounds are specialized.
+//
+//The functions are out of line in libbcd.a, so a call through this
+//header costs a call unless the client is compiled and linked with
+//-flto: the library's objects also carry LTO bytecode, which lets the
+//link inline each width's kernel into its caller.
+//
+//The bcd_*_any() macros select the function for the type of their
+//first Bcd argument using _Generic, so that code can be written once
+//for all widths:
+//
+//  unsigned short x = 0x99, y = 0x1;
+//  BcdError err = OK_ERR;
+//  unsigned short z = bcd_add_any(x, y, &err);   //calls bcd_add_u16()
+//
+//Note that integer constants have type int, so they must be cast to
+//the intended width before being passed as the first argument.
+
+#include "bcderror.h"
+
+#include <limits.h>
+#include <stddef.h>
+
+#define BCD_DECLARE_WIDTH(T, suffix) \
+  T binary_to_bcd_##suffix(T value, BcdError *error); \
+  T bcd_to_binary_##suffix(T bcd, BcdError *error); \
+  T str_to_bcd_##suffix(const char *s, const char **p, BcdError *error); \
+  int bcd_to_str_##suffix(T bcd, char buf[], size_t bufSize, \
+                          BcdError *error); \
+  T bcd_add_##suffix(T x, T y, BcdError *error); \
+  T bcd_multiply_##suffix(T x, T y, BcdError *error); \
+  size_t bcd_add_n_##suffix(const T x[], const T y[], T z[], size_t n, \
+                            BcdErrorBits errors[]); \
+  size_t bcd_mul_small_n_##suffix(const T x[], unsigned m, T z[], \
+                                  size_t n, BcdErrorBits errors[]); \
+  T bcd_sum_reduce_##suffix(const T x[], size_t n, BcdErrorBits errors[], \
+                            BcdError *error);
+
+BCD_DECLARE_WIDTH(unsigned char, u8)
+BCD_DECLARE_WIDTH(unsigned short, u16)
+BCD_DECLARE_WIDTH(unsigned, u32)
+BCD_DECLARE_WIDTH(unsigned long long, u64)
+
+#undef BCD_DECLARE_WIDTH
+
+//unsigned long has the same width as one of the above
+#if ULONG_MAX == UINT_MAX
+  #define BCD_UL_FN(name) name##_u32
+#else
+  #define BCD_UL_FN(name) name##_u64
+#endif
+
+#define BCD_GENERIC_FN(name, x) \
+  _Generic((x), \
+    unsigned char: name##_u8, \
+    unsigned short: name##_u16, \
+    unsigned: name##_u32, \
+    unsigned long: BCD_UL_FN(name), \
+    unsigned long long: name##_u64)
+
+#define binary_to_bcd_any(value, error) \
+  BCD_GENERIC_FN(binary_to_bcd, value)(value, error)
+#define bcd_to_binary_any(bcd, error) \
+  BCD_GENERIC_FN(bcd_to_binary, bcd)(bcd, error)
+#define bcd_to_str_any(bcd, buf, bufSize, error) \
+  BCD_GENERIC_FN(bcd_to_str, bcd)(bcd, buf, bufSize, error)
+#define bcd_add_any(x, y, error) \
+  BCD_GENERIC_FN(bcd_add, x)(x, y, error)
+#define bcd_multiply_any(x, y, error) \
+  BCD_GENERIC_FN(bcd_multiply, x)(x, y, error)
+
+//batch API: dispatch on the element type of the first array.  An
+//array of unsigned long cannot be passed as an array of the type of
+//the same width, which is a different type, so it is not accepted
+#define BCD_GENERIC_ARRAY_FN(name, x) \
+  _Generic((x)[0], \
+    unsigned char: name##_u8, \
+    unsigned short: name##_u16, \
+    unsigned: name##_u32, \
+    unsigned long long: name##_u64)
+
+#define bcd_add_n_any(x, y, z, n, errors) \
+  BCD_GENERIC_ARRAY_FN(bcd_add_n, x)(x, y, z, n, errors)
+#define bcd_mul_small_n_any(x, m, z, n, errors) \
+  BCD_GENERIC_ARRAY_FN(bcd_mul_small_n, x)(x, m, z, n, errors)
+#define bcd_sum_reduce_any(x, n, errors, error) \
+  BCD_GENERIC_ARRAY_FN(bcd_sum_reduce, x)(x, n, errors, error)
+
+//str_to_bcd() has no Bcd argument: dispatch on the type of *result
+#define str_to_bcd_any(result, s, p, error) \
+  (*(result) = BCD_GENERIC_FN(str_to_bcd, *(result))(s, p, error))
+
+#endif //ifndef BCDGENERIC_H_
@@ -0,0 +1,163 @@
+#ifndef BCDKERNELS_H_
+#define BCDKERNELS_H_
+
+//Private helpers shared by the BCD implementations.  These are
+//independent of BCD_BASE: they operate on up to 16 packed digits.
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif
+
+/** SWAR helpers: packed digits are manipulated in a BcdWide so that
+ *  narrow Bcd types are not subject to integer promotion.  A BcdWide
+ *  holds up to 16 packed digits.
+ */
+typedef unsigned long long BcdWide;
+
+//0x11...1: a 1 in the LSB of each of the 16 digits of a BcdWide
+#define BCD_WIDE_NIBBLE_ONES 0x1111111111111111ULL
+
+/** Return non-zero iff some digit in bcd is > 9: that is, a digit
+ *  whose bit 3 is set along with bit 2 or bit 1.
+ */
+static inline BcdWide
+bad_digits(BcdWide bcd)
+{
+	return bcd & ((bcd << 1) | (bcd << 2)) & (BCD_WIDE_NIBBLE_ONES * 8);
+}
+
+/** Return the 16-digit BCD sum x + y + carryIn (carryIn 0 or 1) and
+ *  set *carryOut to the decimal carry out of the top digit.  x and
+ *  y must not contain bad digits.
+ */
+static inline BcdWide
+bcd_wide_add(BcdWide x, BcdWide y, BcdWide carryIn, BcdWide *carryOut)
+{
+	//bias every digit of x by 6 so that a decimal carry out of a
+	//digit shows up as a binary carry out of its nibble
+	BcdWide biased = x + BCD_WIDE_NIBBLE_ONES*6;
+	BcdWide sum0 = biased + y;
+	BcdWide sum = sum0 + carryIn;
+	BcdWide carry = (sum0 < biased) | (sum < sum0);
+	BcdWide carryIns = biased ^ y ^ sum;
+
+	//nibbles which did not carry out still hold digit + 6: undo bias
+	BcdWide noCarry = ((~carryIns >> 4) & (BCD_WIDE_NIBBLE_ONES >> 4)) |
+		((carry ^ 1) << 60);
+	*carryOut = carry;
+	return sum - noCarry*6;
+}
+
+//BCD_PAIRS[i] is the 2-digit packed BCD representation of i < 100
+#define BCD_PAIR_ROW(t) \
+	0x##t##0, 0x##t##1, 0x##t##2, 0x##t##3, 0x##t##4, \
+	0x##t##5, 0x##t##6, 0x##t##7, 0x##t##8, 0x##t##9
+static const unsigned char BCD_PAIRS[100] = {
+	BCD_PAIR_ROW(0), BCD_PAIR_ROW(1), BCD_PAIR_ROW(2), BCD_PAIR_ROW(3),
+	BCD_PAIR_ROW(4), BCD_PAIR_ROW(5), BCD_PAIR_ROW(6), BCD_PAIR_ROW(7),
+	BCD_PAIR_ROW(8), BCD_PAIR_ROW(9)
+};
+#undef BCD_PAIR_ROW
+
+/** Return the 4-digit packed BCD representation of x < 10000. */
+static inline BcdWide
+bcd4(unsigned x)
+{
+	unsigned hi = (x * 5243) >> 19;  //x / 100, exact for x < 43699
+	return ((BcdWide)BCD_PAIRS[hi] << 8) | BCD_PAIRS[x - hi*100];
+}
+
+/************************ ASCII <-> BCD Vectors ************************/
+
+//# of ASCII digits handled by one vector: the # of digits in a
+//BcdWide
+enum { ASCII_VEC_SIZE = sizeof(BcdWide) * 2 };
+
+#ifdef __SSE2__
+
+/** Return non-zero iff 16 bytes can be loaded from s without
+ *  crossing into a (possibly unmapped) following page.
+ *
+ *  The load may still read up to 15 bytes past the end of the string
+ *  or its allocation.  That cannot fault, since memory is mapped a page
+ *  at a time, and the bytes past the first non-digit never affect the
+ *  result, but memory checkers see an out-of-bounds read: the load is
+ *  therefore exempt from AddressSanitizer, and Valgrind may report it
+ *  as an invalid read of size 16.
+ */
+static inline int
+can_load16(const char *s)
+{
+	enum { PAGE_SIZE = 4096 };
+	return ((uintptr_t)s & (PAGE_SIZE - 1)) <= PAGE_SIZE - 16;
+}
+
+/** Return the # of leading decimal digits in s[0, 16) and set *packed
+ *  to those digits packed as BCD.  All 16 characters are validated
+ *  with one compare; pairs of digits are then merged into bytes and
+ *  the bytes reversed into significance order.
+ */
+__attribute__((no_sanitize_address))
+static inline int
+pack16_digits(const char *s, BcdWide *packed)
+{
+	__m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)s),
+				 _mm_set1_epi8('0'));
+	//digit iff (unsigned)(c - '0') <= 9
+	__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(9)), v);
+	unsigned notDigits = ~_mm_movemask_epi8(isDigit) & 0xffff;
+	int n = (notDigits == 0) ? 16 : __builtin_ctz(notDigits);
+	if (n == 0)
+	{
+		*packed = 0;
+		return 0;
+	}
+
+	//16-bit lane holds s[2i] | s[2i+1] << 8: form s[2i] << 4 | s[2i+1];
+	//keep only the low nibbles so that non-digits cannot saturate pack
+	v = _mm_and_si128(v, _mm_set1_epi8(0x0f));
+	__m128i pairs = _mm_or_si128(
+		_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), 4),
+		_mm_srli_epi16(v, 8));
+	__m128i bytes = _mm_packus_epi16(pairs, _mm_setzero_si128());
+	unsigned long long lo;
+	_mm_storel_epi64((__m128i *)&lo, bytes);
+
+	//s[0] ended up in the low byte: reverse so it is most significant,
+	//then drop the nibbles corresponding to non-digit characters
+	BcdWide all16 = __builtin_bswap64(lo);
+	*packed = all16 >> (4 * (16 - n));
+	return n;
+}
+
+/** Set digits[16] to the ASCII digits of the 16 nibbles of bcd, most
+ *  significant first.  Does not validate the nibbles.
+ */
+static inline void
+unpack16_digits(BcdWide bcd, char digits[])
+{
+	__m128i v = _mm_cvtsi64_si128(__builtin_bswap64(bcd));
+	__m128i mask = _mm_set1_epi8(0x0f);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+	__m128i lo = _mm_and_si128(v, mask);
+	__m128i ascii = _mm_add_epi8(_mm_unpacklo_epi8(hi, lo),
+				     _mm_set1_epi8('0'));
+	_mm_storeu_si128((__m128i *)digits, ascii);
+}
+
+#else
+
+static inline void
+unpack16_digits(BcdWide bcd, char digits[])
+{
+	for (int i = ASCII_VEC_SIZE - 1; i >= 0; i--, bcd >>= 4)
+	{
+		digits[i] = '0' + (bcd & 0xf);
+	}
+}
+
+#endif //ifdef __SSE2__
+
+#endif //ifndef BCDKERNELS_H_
@@ -1,9 +1,15 @@
+#define _POSIX_C_SOURCE 200809L  //for fileno(), mmap()
+
 #include "bcd.h"
 
 #include <ctype.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 static inline const char *
 skip_whitespace(const char *p) {
@@ -11,55 +17,78 @@ skip_whitespace(const char *p) {
   return p;
 }
 
-static int
-is_error(BcdError err)
+/** Like skip_whitespace() but does not skip past the end of a line. */
+static inline const char *
+skip_blanks(const char *p) {
+  while (*p != '\n' && isspace(*p)) p++;
+  return p;
+}
+
+static const char *
+error_message(BcdError err)
 {
   switch (err) {
     case BAD_VALUE_ERR:
-      fprintf(stderr, "bad BCD value > 9\n");
-      return 1;
+      return "bad BCD value > 9";
     case OVERFLOW_ERR:
-      fprintf(stderr, "BCD overflow\n");
-      return 1;
+      return "BCD overflow";
     default:
-      break;
+      return NULL;
   }
-  return 0;
 }
 
-int
-main()
+static int
+is_error(BcdError err)
+{
+  const char *msg = error_message(err);
+  if (msg != NULL) fprintf(stderr, "%s\n", msg);
+  return msg != NULL;
+}
+
+/** Evaluate the expression NUMBER [ ('+' | '*') NUMBER ] starting at p
+ *  into *result.  Returns a pointer past the expression and any
+ *  following blanks; the caller checks that it is at the end of the
+ *  line.  If an error occurs, *err is set and evaluation stops.
+ */
+static const char *
+eval_expr(const char *p, Bcd *result, BcdError *err)
+{
+  p = skip_blanks(p);
+  Bcd value = str_to_bcd(p, &p, err);
+  if (*err != OK_ERR) return p;
+  p = skip_blanks(p);
+  if (*p == '+' || *p == '*') {
+    char op = *p;
+    p = skip_blanks(p + 1);
+    Bcd operand2 = str_to_bcd(p, &p, err);
+    if (*err != OK_ERR) return p;
+    value = (op == '+')
+      ? bcd_add(value, operand2, err)
+      : bcd_multiply(value, operand2, err);
+    if (*err != OK_ERR) return p;
+    p = skip_blanks(p);
+  }
+  *result = value;
+  return p;
+}
+
+static void
+interactive(void)
 {
-  enum { LINE_MAX = 80 };
-  char line[LINE_MAX];
+  enum { MAX_LINE = 80 };
+  char line[MAX_LINE];
   printf("BCD_BASE == %d, sizeof(Bcd) == %zu\n", BCD_BASE, sizeof(Bcd));
   while (printf(">> ") && fflush(stdout) == 0 &&
-         fgets(line, LINE_MAX, stdin) != NULL) {
+         fgets(line, MAX_LINE, stdin) != NULL) {
     BcdError err = OK_ERR;
     if (line[strlen(line) - 1] != '\n') {
       fprintf(stderr, "line too long ... ignored\n");
       continue;
     }
-    const char *p = skip_whitespace(line);
-    Bcd result = str_to_bcd(p, &p, &err);
+    Bcd result;
+    const char *p = eval_expr(line, &result, &err);
     if (is_error(err)) continue;
-    p = skip_whitespace(p);
-    if (*p == '+') {
-      p = skip_whitespace(p + 1);
-      Bcd operand2 = str_to_bcd(p, &p, &err);
-      if (is_error(err)) continue;
-      result = bcd_add(result, operand2, &err);
-      if (is_error(err)) continue;
-    }
-    else if (*p == '*') {
-      p = skip_whitespace(p + 1);
-      Bcd operand2 = str_to_bcd(p, &p, &err);
-      if (is_error(err)) continue;
-      result = bcd_multiply(result, operand2, &err);
-      if (is_error(err)) continue;
-    }
-    p = skip_whitespace(p);
-    if (*p != '\0') {
+    if (*skip_whitespace(p) != '\0') {
       fprintf(stderr, "bad input %s", line);
     }
     else {
@@ -69,8 +98,197 @@ main()
       printf("%s (%" BCD_FORMAT_MODIFIER "u)\n", buf, result);
     }
   }
-  if (ferror(stdin)) {
-    fprintf(stderr, "i/o error on stdin: %s\n", strerror(errno));
+}
+
+/****************************** Batch Mode *****************************/
+
+//Batch mode evaluates one expression per line of a whole file with
+//the same output as interactive(), minus the banner and prompts.  The
+//input is mapped (or read in big blocks) and parsed in place: every
+//complete line ends in '\n', which stops str_to_bcd().  Results are
+//formatted straight into one big output buffer.
+
+enum {
+  BLOCK_SIZE = 1 << 20,
+
+  //max output for one line: "DIGITS (VALUE)\n" where VALUE is the raw
+  //Bcd printed in decimal (at most 20 digits)
+  MAX_RESULT_SIZE = BCD_BUF_SIZE + 20 + 4,
+};
+
+typedef struct {
+  char buf[BLOCK_SIZE];
+  size_t n;
+} Output;
+
+static void
+flush_output(Output *out)
+{
+  if (fwrite(out->buf, 1, out->n, stdout) != out->n) {
+    fprintf(stderr, "i/o error on stdout: %s\n", strerror(errno));
+    exit(1);
+  }
+  out->n = 0;
+}
+
+/** Append "DIGITS (VALUE)\n" for result to out. */
+static void
+output_result(Output *out, Bcd result, BcdError *err)
+{
+  if (out->n + MAX_RESULT_SIZE > sizeof(out->buf)) flush_output(out);
+  char *p = &out->buf[out->n];
+  p += bcd_to_str(result, p, BCD_BUF_SIZE, err);
+  if (*err != OK_ERR) return;
+  *p++ = ' '; *p++ = '(';
+  char digits[20];
+  int nDigits = 0;
+  unsigned long long value = result;
+  do {
+    digits[nDigits++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  while (nDigits > 0) *p++ = digits[--nDigits];
+  *p++ = ')'; *p++ = '\n';
+  out->n = p - out->buf;
+}
+
+/** Evaluate the complete lines in [p, end), where end[-1] == '\n'. */
+static void
+eval_lines(const char *p, const char *end, size_t *lineNum, Output *out)
+{
+  while (p < end) {
+    const char *eol = memchr(p, '\n', end - p);
+    ++*lineNum;
+    BcdError err = OK_ERR;
+    Bcd result;
+    const char *q = eval_expr(p, &result, &err);
+    if (err == OK_ERR && q != eol) {
+      fprintf(stderr, "line %zu: bad input %.*s\n", *lineNum,
+              (int)(eol - p), p);
+    }
+    else {
+      if (err == OK_ERR) output_result(out, result, &err);
+      if (err != OK_ERR) {
+        fprintf(stderr, "line %zu: %s\n", *lineNum, error_message(err));
+      }
+    }
+    p = eol + 1;
+  }
+}
+
+/** Return p resized to size bytes; exits the program on failure. */
+static void *
+must_realloc(void *p, size_t size)
+{
+  void *q = realloc(p, size);
+  if (!q) {
+    fprintf(stderr, "cannot allocate %zu bytes\n", size);
+    exit(1);
+  }
+  return q;
+}
+
+/** Evaluate a final line [p, end) which has no '\n'. */
+static void
+eval_last_line(const char *p, const char *end, size_t *lineNum,
+               Output *out)
+{
+  if (p == end) return;
+  size_t n = end - p;
+  char *line = must_realloc(NULL, n + 2);
+  memcpy(line, p, n);
+  line[n] = '\n'; line[n + 1] = '\0';
+  eval_lines(line, line + n + 1, lineNum, out);
+  free(line);
+}
+
+/** Return true after evaluating a regular-file stdin through mmap(). */
+static int
+eval_mapped(size_t *lineNum, Output *out)
+{
+  struct stat st;
+  if (fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size == 0) {
+    return 0;
+  }
+  size_t size = st.st_size;
+  char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+  if (data == MAP_FAILED) return 0;
+  posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+  const char *end = data + size;
+  const char *last = end;
+  while (last > data && last[-1] != '\n') last--;
+  eval_lines(data, last, lineNum, out);
+  eval_last_line(last, end, lineNum, out);
+  munmap(data, size);
+  return 1;
+}
+
+/** Evaluate stdin by reading it in blocks; a partial line at the end
+ *  of a block is moved to the start of the buffer for the next read.
+ */
+static void
+eval_read(size_t *lineNum, Output *out)
+{
+  size_t size = BLOCK_SIZE;
+  char *buf = must_realloc(NULL, size);
+  size_t n = 0;   //# of bytes of a partial line at start of buf
+  for (;;) {
+    if (n == size) buf = must_realloc(buf, size *= 2);  //very long line
+    ssize_t nRead = read(STDIN_FILENO, buf + n, size - n);
+    if (nRead < 0 && errno == EINTR) continue;
+    if (nRead < 0) {
+      fprintf(stderr, "i/o error on stdin: %s\n", strerror(errno));
+      break;
+    }
+    if (nRead == 0) {
+      eval_last_line(buf, buf + n, lineNum, out);
+      break;
+    }
+    const char *end = buf + n + nRead;
+    const char *last = end;
+    while (last > buf + n && last[-1] != '\n') last--;
+    if (last == buf + n) {  //no complete line yet
+      n += nRead;
+      continue;
+    }
+    eval_lines(buf, last, lineNum, out);
+    n = end - last;
+    memmove(buf, last, n);
+  }
+  free(buf);
+}
+
+static void
+batch(void)
+{
+  static Output out;
+  size_t lineNum = 0;
+  if (!eval_mapped(&lineNum, &out)) eval_read(&lineNum, &out);
+  flush_output(&out);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int isBatch = !isatty(STDIN_FILENO);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-b") == 0) {
+      isBatch = 1;
+    }
+    else {
+      fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (isBatch) {
+    batch();
+  }
+  else {
+    interactive();
+    if (ferror(stdin)) {
+      fprintf(stderr, "i/o error on stdin: %s\n", strerror(errno));
+    }
   }
   return 0;
 }